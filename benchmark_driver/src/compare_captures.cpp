@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ppm_image/ppm_image.hpp"
+
+// checks that runs render the same frames: every frame_*.ppm written by
+// --capture in the reference directory is compared against the file of the
+// same name in each other directory, reporting how many pixels differ and by
+// how much, the exit code is 1 when a frame is missing or differs by more
+// than the tolerance
+
+struct FrameDifference {
+  // pixels with any channel differing by more than the tolerance
+  size_t differing_pixels = 0;
+  int max_difference = 0;
+};
+
+static std::vector<std::string> list_frames(const std::filesystem::path &dir) {
+  std::vector<std::string> frames;
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(dir, error))
+    if (entry.is_regular_file() && entry.path().extension() == ".ppm")
+      frames.push_back(entry.path().filename().string());
+  std::sort(frames.begin(), frames.end());
+  return frames;
+}
+
+static FrameDifference compare_images(const Image &reference,
+                                      const Image &image, int tolerance) {
+  FrameDifference difference;
+  for (size_t pixel = 0; pixel < reference.pixels.size(); pixel += 3) {
+    int pixel_difference = 0;
+    for (size_t channel = pixel; channel < pixel + 3; ++channel)
+      pixel_difference =
+          std::max(pixel_difference, std::abs(int(reference.pixels[channel]) -
+                                              int(image.pixels[channel])));
+    difference.max_difference =
+        std::max(difference.max_difference, pixel_difference);
+    if (pixel_difference > tolerance)
+      ++difference.differing_pixels;
+  }
+  return difference;
+}
+
+// returns whether every reference frame matched
+static bool compare_directory(const std::filesystem::path &reference_dir,
+                              const std::vector<std::string> &frames,
+                              const std::filesystem::path &dir,
+                              int tolerance) {
+  int matching = 0;
+  int max_difference = 0;
+  for (const std::string &frame : frames) {
+    Image reference, image;
+    if (!read_ppm((reference_dir / frame).string(), reference))
+      return false;
+    if (!std::filesystem::exists(dir / frame)) {
+      std::cout << "  " << frame << ": missing\n";
+      continue;
+    }
+    if (!read_ppm((dir / frame).string(), image))
+      continue;
+    if (image.width != reference.width || image.height != reference.height) {
+      std::cout << "  " << frame << ": " << image.width << "x"
+                << image.height << " instead of " << reference.width << "x"
+                << reference.height << '\n';
+      continue;
+    }
+    FrameDifference difference = compare_images(reference, image, tolerance);
+    max_difference = std::max(max_difference, difference.max_difference);
+    if (difference.differing_pixels == 0) {
+      ++matching;
+      continue;
+    }
+    std::cout << "  " << frame << ": " << difference.differing_pixels
+              << " pixels differ, by up to " << difference.max_difference
+              << '\n';
+  }
+  std::cout << dir.string() << ": " << matching << " of " << frames.size()
+            << " frames match, max difference " << max_difference << '\n';
+  return matching == static_cast<int>(frames.size());
+}
+
+int main(int argc, char *argv[]) {
+  int tolerance = 0;
+  std::vector<std::filesystem::path> dirs;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--tolerance" && i + 1 < argc) {
+      tolerance = std::atoi(argv[++i]);
+    } else {
+      dirs.push_back(arg);
+    }
+  }
+  if (dirs.empty() || tolerance < 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--tolerance <n>] <reference_dir> [<dir>...]\n"
+                 "a single directory compares its subdirectories, one per "
+                 "driver run, against the first\n";
+    return 1;
+  }
+
+  if (dirs.size() == 1) {
+    std::filesystem::path parent = dirs[0];
+    dirs.clear();
+    std::error_code error;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(parent, error))
+      if (entry.is_directory())
+        dirs.push_back(entry.path());
+    std::sort(dirs.begin(), dirs.end());
+    if (dirs.size() < 2) {
+      std::cerr << "Error: " << parent.string()
+                << " holds fewer than two captured runs.\n";
+      return 1;
+    }
+  }
+
+  std::vector<std::string> frames = list_frames(dirs[0]);
+  if (frames.empty()) {
+    std::cerr << "Error: no frames captured in " << dirs[0].string() << ".\n";
+    return 1;
+  }
+  std::cout << "Reference: " << dirs[0].string() << ", " << frames.size()
+            << " frames, tolerance " << tolerance << '\n';
+
+  bool all_match = true;
+  for (size_t i = 1; i < dirs.size(); ++i)
+    all_match &= compare_directory(dirs[0], frames, dirs[i], tolerance);
+  return all_match ? 0 : 1;
+}
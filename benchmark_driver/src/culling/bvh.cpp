@@ -0,0 +1,192 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+// spreads the low 10 bits of value so there are two zero bits between each
+static uint32_t spread_bits(uint32_t value) {
+  value &= 0x3ff;
+  value = (value | (value << 16)) & 0x030000ff;
+  value = (value | (value << 8)) & 0x0300f00f;
+  value = (value | (value << 4)) & 0x030c30c3;
+  value = (value | (value << 2)) & 0x09249249;
+  return value;
+}
+
+// sorts each of a few chunks in parallel, then merges neighbouring chunks
+// pairwise in parallel until one is left
+static void parallel_sort(ThreadPool &pool, std::vector<uint64_t> &keys) {
+  size_t num_chunks = pool.get_num_threads() + 1;
+  size_t chunk_size = (keys.size() + num_chunks - 1) / num_chunks;
+  if (chunk_size < 4096) {
+    std::sort(keys.begin(), keys.end());
+    return;
+  }
+
+  auto chunk_begin = [&](size_t chunk) {
+    return keys.begin() + std::min(keys.size(), chunk * chunk_size);
+  };
+  pool.parallel_for(
+      num_chunks,
+      [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk)
+          std::sort(chunk_begin(chunk), chunk_begin(chunk + 1));
+      },
+      1);
+  for (size_t width = 1; width < num_chunks; width *= 2) {
+    size_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    pool.parallel_for(
+        num_merges,
+        [&](size_t first, size_t last) {
+          for (size_t merge = first; merge < last; ++merge) {
+            size_t left = merge * 2 * width;
+            std::inplace_merge(chunk_begin(left), chunk_begin(left + width),
+                               chunk_begin(left + 2 * width));
+          }
+        },
+        1);
+  }
+}
+
+void Bvh::build(ThreadPool &pool, std::span<const glm::mat4> model_matrices,
+                float object_radius) {
+  this->object_radius = object_radius;
+  size_t num_objects = model_matrices.size();
+
+  std::vector<uint32_t> identity(num_objects);
+  std::iota(identity.begin(), identity.end(), 0u);
+  std::vector<glm::vec4> object_spheres;
+  compute_bounding_spheres(pool, model_matrices, identity, object_radius,
+                           object_spheres);
+  Bounds scene_bounds = compute_center_bounds(pool, object_spheres);
+
+  // the morton code goes in the high half and the object index in the low
+  // half, which makes the sort order unique and carries the index along
+  glm::vec3 extent = scene_bounds.max - scene_bounds.min;
+  std::vector<uint64_t> keys(num_objects);
+  pool.parallel_for(num_objects, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      uint32_t code = 0;
+      for (int axis = 0; axis < 3; ++axis) {
+        float position = extent[axis] > 0.0f
+                             ? (object_spheres[i][axis] -
+                                scene_bounds.min[axis]) /
+                                   extent[axis]
+                             : 0.0f;
+        uint32_t quantized = std::min(static_cast<uint32_t>(position * 1024.0f),
+                                      1023u);
+        code |= spread_bits(quantized) << axis;
+      }
+      keys[i] = static_cast<uint64_t>(code) << 32 | i;
+    }
+  });
+  parallel_sort(pool, keys);
+
+  objects.resize(num_objects);
+  spheres.resize(num_objects);
+  pool.parallel_for(num_objects, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      objects[i] = static_cast<uint32_t>(keys[i]);
+      spheres[i] = object_spheres[objects[i]];
+    }
+  });
+
+  num_leaves = (num_objects + leaf_size - 1) / leaf_size;
+  num_leaf_slots = std::bit_ceil(std::max(num_leaves, 1u));
+  compute_node_bounds(pool);
+}
+
+void Bvh::compute_node_bounds(ThreadPool &pool) {
+  // slots past the last leaf stay empty and are never visited
+  nodes.assign(2 * num_leaf_slots, Bounds());
+
+  pool.parallel_for(num_leaves, [&](size_t first, size_t last) {
+    for (size_t leaf = first; leaf < last; ++leaf) {
+      Bounds bounds;
+      size_t end = std::min(spheres.size(), (leaf + 1) * leaf_size);
+      for (size_t i = leaf * leaf_size; i < end; ++i)
+        bounds.add_sphere(spheres[i]);
+      nodes[num_leaf_slots + leaf] = bounds;
+    }
+  });
+
+  for (uint32_t level_start = num_leaf_slots / 2; level_start >= 1;
+       level_start /= 2) {
+    pool.parallel_for(level_start, [&](size_t first, size_t last) {
+      for (size_t node = level_start + first; node < level_start + last;
+           ++node) {
+        nodes[node] = nodes[2 * node];
+        nodes[node].add_bounds(nodes[2 * node + 1]);
+      }
+    });
+  }
+}
+
+void Bvh::refit(ThreadPool &pool, std::span<const glm::mat4> model_matrices) {
+  compute_bounding_spheres(pool, model_matrices, objects, object_radius,
+                           spheres);
+  compute_node_bounds(pool);
+}
+
+void Bvh::query(ThreadPool &pool, const Frustum &frustum,
+                std::vector<std::vector<uint32_t>> &visible) const {
+  // the query roots are a whole level of the tree, the levels above them only
+  // save box tests and are skipped
+  uint32_t num_roots = std::min(num_leaf_slots, max_query_roots);
+  int leaf_depth = std::countr_zero(num_leaf_slots);
+  visible.resize(get_num_query_lists(pool));
+  size_t roots_per_list = (num_roots + visible.size() - 1) / visible.size();
+
+  pool.parallel_for(
+      visible.size(),
+      [&](size_t first_list, size_t last_list) {
+        for (size_t list = first_list; list < last_list; ++list) {
+          std::vector<uint32_t> &list_objects = visible[list];
+          list_objects.clear();
+
+          uint32_t stack[max_query_roots + 64];
+          int stack_size = 0;
+          size_t first_root = std::min<size_t>(num_roots, list * roots_per_list);
+          size_t last_root =
+              std::min<size_t>(num_roots, first_root + roots_per_list);
+          for (size_t root = last_root; root > first_root; --root)
+            stack[stack_size++] = num_roots + root - 1;
+
+          while (stack_size > 0) {
+            uint32_t node = stack[--stack_size];
+            // the leaves below node are a contiguous range
+            int height = leaf_depth - (std::bit_width(node) - 1);
+            uint32_t first_leaf = (node << height) - num_leaf_slots;
+            if (first_leaf >= num_leaves)
+              continue;
+
+            const Bounds &bounds = nodes[node];
+            Containment containment =
+                classify_box(frustum, bounds.min, bounds.max);
+            if (containment == Containment::outside)
+              continue;
+
+            size_t first_object = static_cast<size_t>(first_leaf) * leaf_size;
+            size_t last_object =
+                std::min(objects.size(),
+                         (static_cast<size_t>(first_leaf) + (1u << height)) *
+                             leaf_size);
+            if (containment == Containment::inside) {
+              list_objects.insert(list_objects.end(),
+                                  objects.begin() + first_object,
+                                  objects.begin() + last_object);
+            } else if (height == 0) {
+              for (size_t i = first_object; i < last_object; ++i)
+                if (sphere_in_frustum(frustum, glm::vec3(spheres[i]),
+                                      spheres[i].w))
+                  list_objects.push_back(objects[i]);
+            } else {
+              stack[stack_size++] = 2 * node + 1;
+              stack[stack_size++] = 2 * node;
+            }
+          }
+        }
+      },
+      1);
+}
@@ -0,0 +1,38 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "spatial_index.hpp"
+
+// a bounding volume hierarchy laid out flat, objects are sorted along a
+// morton curve of their centers and cut into leaves of leaf_size, the leaves
+// sit under an implicit complete binary tree stored heap style (node 1 is
+// the root, node i has children 2 i and 2 i + 1, leaf k is node
+// num_leaf_slots + k), so there are no child pointers and every level is
+// contiguous, refit recomputes the levels bottom up
+class Bvh : public SpatialIndex {
+public:
+  void build(ThreadPool &pool, std::span<const glm::mat4> model_matrices,
+             float object_radius) override;
+  void refit(ThreadPool &pool,
+             std::span<const glm::mat4> model_matrices) override;
+  void query(ThreadPool &pool, const Frustum &frustum,
+             std::vector<std::vector<uint32_t>> &visible) const override;
+
+private:
+  static constexpr uint32_t leaf_size = 16;
+  // queries start this many nodes below the root, one task per node range
+  static constexpr uint32_t max_query_roots = 256;
+
+  void compute_node_bounds(ThreadPool &pool);
+
+  float object_radius = 0.0f;
+  uint32_t num_leaves = 0;
+  // num_leaves rounded up to a power of two
+  uint32_t num_leaf_slots = 0;
+  std::vector<Bounds> nodes;
+  // object indices and their spheres in morton order
+  std::vector<uint32_t> objects;
+  std::vector<glm::vec4> spheres;
+};
+
+#endif // BVH_HPP
@@ -0,0 +1,13 @@
+#include "frustum.hpp"
+
+Frustum extract_frustum(const glm::mat4 &view_projection) {
+  // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+  glm::mat4 rows = glm::transpose(view_projection);
+
+  Frustum frustum;
+  frustum.planes = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                    rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]};
+  for (glm::vec4 &plane : frustum.planes)
+    plane /= glm::length(glm::vec3(plane));
+  return frustum;
+}
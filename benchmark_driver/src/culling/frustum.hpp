@@ -0,0 +1,59 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <array>
+#include <glm/glm.hpp>
+
+// the six clip planes of a view projection matrix, each as (normal, distance)
+// with the normal pointing inside and normalized so that plane distances are
+// in world units
+struct Frustum {
+  std::array<glm::vec4, 6> planes;
+};
+
+// Gribb / Hartmann extraction from the rows of projection * view
+Frustum extract_frustum(const glm::mat4 &view_projection);
+
+// conservative, spheres crossing a plane count as visible
+inline bool sphere_in_frustum(const Frustum &frustum, glm::vec3 center,
+                              float radius) {
+  for (const glm::vec4 &plane : frustum.planes)
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+      return false;
+  return true;
+}
+
+enum class Containment { outside, intersecting, inside };
+
+// classifies an axis aligned box, for each plane only the corner farthest
+// along the normal can decide outside and only the nearest one can decide
+// inside
+inline Containment classify_box(const Frustum &frustum, glm::vec3 min,
+                                glm::vec3 max) {
+  Containment containment = Containment::inside;
+  for (const glm::vec4 &plane : frustum.planes) {
+    glm::vec3 farthest(plane.x >= 0.0f ? max.x : min.x,
+                       plane.y >= 0.0f ? max.y : min.y,
+                       plane.z >= 0.0f ? max.z : min.z);
+    if (glm::dot(glm::vec3(plane), farthest) + plane.w < 0.0f)
+      return Containment::outside;
+    glm::vec3 nearest(plane.x >= 0.0f ? min.x : max.x,
+                      plane.y >= 0.0f ? min.y : max.y,
+                      plane.z >= 0.0f ? min.z : max.z);
+    if (glm::dot(glm::vec3(plane), nearest) + plane.w < 0.0f)
+      containment = Containment::intersecting;
+  }
+  return containment;
+}
+
+// world space bounding sphere of an object drawn with model, the mesh's
+// object space sphere is centered on the origin
+inline float get_bounding_radius(const glm::mat4 &model,
+                                 float object_radius) {
+  float scale = glm::max(glm::length(glm::vec3(model[0])),
+                         glm::max(glm::length(glm::vec3(model[1])),
+                                  glm::length(glm::vec3(model[2]))));
+  return object_radius * scale;
+}
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,45 @@
+#include "spatial_index.hpp"
+
+#include <mutex>
+
+#include "bvh.hpp"
+#include "uniform_grid.hpp"
+
+std::unique_ptr<SpatialIndex> create_spatial_index(SpatialIndexType type) {
+  if (type == SpatialIndexType::uniform_grid)
+    return std::make_unique<UniformGrid>();
+  return std::make_unique<Bvh>();
+}
+
+void compute_bounding_spheres(ThreadPool &pool,
+                              std::span<const glm::mat4> model_matrices,
+                              std::span<const uint32_t> objects,
+                              float object_radius,
+                              std::vector<glm::vec4> &spheres) {
+  spheres.resize(objects.size());
+  pool.parallel_for(objects.size(), [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const glm::mat4 &model = model_matrices[objects[i]];
+      spheres[i] = glm::vec4(glm::vec3(model[3]),
+                             get_bounding_radius(model, object_radius));
+    }
+  });
+}
+
+Bounds compute_center_bounds(ThreadPool &pool,
+                             const std::vector<glm::vec4> &spheres) {
+  Bounds bounds;
+  std::mutex mutex;
+  pool.parallel_for(spheres.size(), [&](size_t first, size_t last) {
+    Bounds range_bounds;
+    for (size_t i = first; i < last; ++i)
+      range_bounds.add_point(glm::vec3(spheres[i]));
+    std::lock_guard<std::mutex> lock(mutex);
+    bounds.add_bounds(range_bounds);
+  });
+  return bounds;
+}
+
+size_t get_num_query_lists(const ThreadPool &pool) {
+  return (pool.get_num_threads() + 1) * 4;
+}
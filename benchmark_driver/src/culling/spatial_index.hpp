@@ -0,0 +1,88 @@
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "frustum.hpp"
+#include "thread_pool/thread_pool.hpp"
+
+enum class SpatialIndexType {
+  // objects binned by center into cells of about objects_per_cell objects
+  uniform_grid,
+  // objects sorted along a morton curve into fixed size leaves under an
+  // implicit complete binary tree
+  bvh,
+};
+
+// a cpu side acceleration structure over the bounding spheres of the scene's
+// objects, every object keeps the same index it has in the model matrix
+// array, build and refit spread across the pool
+class SpatialIndex {
+public:
+  virtual ~SpatialIndex() = default;
+
+  // computes every object's sphere from its matrix and builds the structure
+  // from scratch
+  virtual void build(ThreadPool &pool,
+                     std::span<const glm::mat4> model_matrices,
+                     float object_radius) = 0;
+
+  // recomputes the spheres of objects that moved and the bounds above them,
+  // the structure itself is kept so its quality degrades as objects travel
+  // away from where they were at build time, but queries stay exact
+  virtual void refit(ThreadPool &pool,
+                     std::span<const glm::mat4> model_matrices) = 0;
+
+  // every object whose sphere is not entirely outside the frustum, split over
+  // several lists that are filled in parallel, the lists are reused between
+  // calls to keep their capacity
+  virtual void query(ThreadPool &pool, const Frustum &frustum,
+                     std::vector<std::vector<uint32_t>> &visible) const = 0;
+};
+
+std::unique_ptr<SpatialIndex> create_spatial_index(SpatialIndexType type);
+
+// helpers shared by the implementations
+
+// an axis aligned box, empty until something is added to it
+struct Bounds {
+  glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+  void add_sphere(const glm::vec4 &sphere) {
+    glm::vec3 center(sphere);
+    min = glm::min(min, center - glm::vec3(sphere.w));
+    max = glm::max(max, center + glm::vec3(sphere.w));
+  }
+  void add_point(const glm::vec3 &point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void add_bounds(const Bounds &bounds) {
+    min = glm::min(min, bounds.min);
+    max = glm::max(max, bounds.max);
+  }
+};
+
+// spheres[i] becomes the (center, radius) of object objects[i], so that the
+// spheres are stored in the order the structure visits them
+void compute_bounding_spheres(ThreadPool &pool,
+                              std::span<const glm::mat4> model_matrices,
+                              std::span<const uint32_t> objects,
+                              float object_radius,
+                              std::vector<glm::vec4> &spheres);
+
+// the box around every sphere center
+Bounds compute_center_bounds(ThreadPool &pool,
+                             const std::vector<glm::vec4> &spheres);
+
+// how many lists a query fills, a few per thread so that uneven work still
+// balances
+size_t get_num_query_lists(const ThreadPool &pool);
+
+#endif // SPATIAL_INDEX_HPP
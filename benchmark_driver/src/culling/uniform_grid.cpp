@@ -0,0 +1,148 @@
+#include "uniform_grid.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+
+void UniformGrid::build(ThreadPool &pool,
+                        std::span<const glm::mat4> model_matrices,
+                        float object_radius) {
+  this->object_radius = object_radius;
+  size_t num_objects = model_matrices.size();
+
+  // spheres in object order first, to find the scene's extent
+  std::vector<uint32_t> identity(num_objects);
+  std::iota(identity.begin(), identity.end(), 0u);
+  std::vector<glm::vec4> object_spheres;
+  compute_bounding_spheres(pool, model_matrices, identity, object_radius,
+                           object_spheres);
+  Bounds scene_bounds = compute_center_bounds(pool, object_spheres);
+
+  // cubic cells sized so that a cell holds objects_per_cell objects on
+  // average if they were spread evenly through the scene's box, flat axes
+  // get a single layer of cells
+  glm::vec3 extent = scene_bounds.max - scene_bounds.min;
+  float volume = 1.0f;
+  int num_axes = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (extent[axis] > 0.0f) {
+      volume *= extent[axis];
+      ++num_axes;
+    }
+  }
+  float cell_size =
+      num_axes == 0 ? 1.0f
+                    : std::pow(volume * objects_per_cell /
+                                   std::max<size_t>(num_objects, 1),
+                               1.0f / num_axes);
+  for (int axis = 0; axis < 3; ++axis)
+    dimensions[axis] = std::clamp(
+        static_cast<int>(std::ceil(extent[axis] / cell_size)), 1, 1024);
+  size_t num_cells =
+      static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2];
+
+  auto get_cell = [&](const glm::vec4 &sphere) {
+    size_t cell = 0;
+    for (int axis = 2; axis >= 0; --axis) {
+      float position = extent[axis] > 0.0f
+                           ? (sphere[axis] - scene_bounds.min[axis]) /
+                                 extent[axis] * dimensions[axis]
+                           : 0.0f;
+      int coordinate =
+          std::clamp(static_cast<int>(position), 0, dimensions[axis] - 1);
+      cell = cell * dimensions[axis] + coordinate;
+    }
+    return cell;
+  };
+
+  // counting sort by cell: count, prefix sum, scatter, the order within a
+  // cell depends on thread timing but queries return the same set
+  std::vector<uint32_t> object_cells(num_objects);
+  std::vector<std::atomic<uint32_t>> cell_counts(num_cells);
+  pool.parallel_for(num_objects, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      object_cells[i] = get_cell(object_spheres[i]);
+      cell_counts[object_cells[i]].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  cell_starts.resize(num_cells + 1);
+  cell_starts[0] = 0;
+  for (size_t cell = 0; cell < num_cells; ++cell) {
+    cell_starts[cell + 1] = cell_starts[cell] + cell_counts[cell].load();
+    cell_counts[cell].store(cell_starts[cell], std::memory_order_relaxed);
+  }
+
+  objects.resize(num_objects);
+  spheres.resize(num_objects);
+  pool.parallel_for(num_objects, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      uint32_t slot = cell_counts[object_cells[i]].fetch_add(
+          1, std::memory_order_relaxed);
+      objects[slot] = i;
+      spheres[slot] = object_spheres[i];
+    }
+  });
+
+  compute_cell_bounds(pool);
+}
+
+void UniformGrid::compute_cell_bounds(ThreadPool &pool) {
+  size_t num_cells = cell_starts.size() - 1;
+  cell_bounds.resize(num_cells);
+  pool.parallel_for(
+      num_cells,
+      [&](size_t first, size_t last) {
+        for (size_t cell = first; cell < last; ++cell) {
+          Bounds bounds;
+          for (uint32_t i = cell_starts[cell]; i < cell_starts[cell + 1]; ++i)
+            bounds.add_sphere(spheres[i]);
+          cell_bounds[cell] = bounds;
+        }
+      },
+      64);
+}
+
+void UniformGrid::refit(ThreadPool &pool,
+                        std::span<const glm::mat4> model_matrices) {
+  compute_bounding_spheres(pool, model_matrices, objects, object_radius,
+                           spheres);
+  compute_cell_bounds(pool);
+}
+
+void UniformGrid::query(ThreadPool &pool, const Frustum &frustum,
+                        std::vector<std::vector<uint32_t>> &visible) const {
+  size_t num_cells = cell_bounds.size();
+  visible.resize(get_num_query_lists(pool));
+  size_t cells_per_list = (num_cells + visible.size() - 1) / visible.size();
+
+  pool.parallel_for(
+      visible.size(),
+      [&](size_t first_list, size_t last_list) {
+        for (size_t list = first_list; list < last_list; ++list) {
+          std::vector<uint32_t> &list_objects = visible[list];
+          list_objects.clear();
+          size_t first_cell = std::min(num_cells, list * cells_per_list);
+          size_t last_cell = std::min(num_cells, first_cell + cells_per_list);
+          for (size_t cell = first_cell; cell < last_cell; ++cell) {
+            uint32_t begin = cell_starts[cell], end = cell_starts[cell + 1];
+            if (begin == end)
+              continue;
+            const Bounds &bounds = cell_bounds[cell];
+            Containment containment =
+                classify_box(frustum, bounds.min, bounds.max);
+            if (containment == Containment::inside) {
+              list_objects.insert(list_objects.end(), objects.begin() + begin,
+                                  objects.begin() + end);
+            } else if (containment == Containment::intersecting) {
+              for (uint32_t i = begin; i < end; ++i)
+                if (sphere_in_frustum(frustum, glm::vec3(spheres[i]),
+                                      spheres[i].w))
+                  list_objects.push_back(objects[i]);
+            }
+          }
+        }
+      },
+      1);
+}
@@ -0,0 +1,35 @@
+#ifndef UNIFORM_GRID_HPP
+#define UNIFORM_GRID_HPP
+
+#include <array>
+
+#include "spatial_index.hpp"
+
+// objects binned by sphere center into a regular grid over the scene, each
+// cell's objects are contiguous (cell_starts[c] .. cell_starts[c + 1]) and
+// each cell keeps the box around its members' spheres, so an object that
+// leaves its cell only makes that cell's box larger
+class UniformGrid : public SpatialIndex {
+public:
+  void build(ThreadPool &pool, std::span<const glm::mat4> model_matrices,
+             float object_radius) override;
+  void refit(ThreadPool &pool,
+             std::span<const glm::mat4> model_matrices) override;
+  void query(ThreadPool &pool, const Frustum &frustum,
+             std::vector<std::vector<uint32_t>> &visible) const override;
+
+private:
+  static constexpr int objects_per_cell = 32;
+
+  void compute_cell_bounds(ThreadPool &pool);
+
+  float object_radius = 0.0f;
+  std::array<int, 3> dimensions{};
+  std::vector<uint32_t> cell_starts;
+  std::vector<Bounds> cell_bounds;
+  // object indices and their spheres in cell order
+  std::vector<uint32_t> objects;
+  std::vector<glm::vec4> spheres;
+};
+
+#endif // UNIFORM_GRID_HPP
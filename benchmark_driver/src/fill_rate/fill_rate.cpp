@@ -0,0 +1,194 @@
+#include "fill_rate.hpp"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+static const std::array<std::pair<DepthMode, const char *>, 4>
+    depth_mode_names = {{
+        {DepthMode::off, "off"},
+        {DepthMode::front_to_back, "front_to_back"},
+        {DepthMode::back_to_front, "back_to_front"},
+        {DepthMode::late_z, "late_z"},
+    }};
+
+bool parse_depth_mode(const std::string &name, DepthMode &mode) {
+  for (const auto &[value, value_name] : depth_mode_names) {
+    if (name == value_name) {
+      mode = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *get_depth_mode_name(DepthMode mode) {
+  for (const auto &[value, value_name] : depth_mode_names)
+    if (value == mode)
+      return value_name;
+  return "unknown";
+}
+
+std::string get_fill_run_name(const FillConfig &config) {
+  std::string run_name = "fill_" + std::to_string(config.triangle_size) +
+                         "px_x" + std::to_string(config.overdraw) + "_" +
+                         get_depth_mode_name(config.depth_mode);
+  if (config.blend)
+    run_name += "_blend";
+  if (config.alu_iterations > 0)
+    run_name += "_alu" + std::to_string(config.alu_iterations);
+  if (config.texture_fetches > 0)
+    run_name += "_tex" + std::to_string(config.texture_fetches);
+  return run_name;
+}
+
+// every instance is a layer, instance 0 is drawn first and is the nearest
+// layer when nearestFirst is set
+static const char *const fill_vertex_shader_source = R"(
+        #version 330 core
+        layout (location = 0) in vec2 position;
+        uniform int layers;
+        uniform bool nearestFirst;
+        out float layer;
+
+        void main() {
+            layer = (float(gl_InstanceID) + 0.5) / float(layers);
+            float depth = nearestFirst ? layer : 1.0 - layer;
+            gl_Position = vec4(position, depth * 1.8 - 0.9, 1.0);
+        }
+    )";
+
+static const char *const fill_fragment_shader_source = R"(
+        #version 330 core
+        in float layer;
+        uniform sampler2D fillTexture;
+        out vec4 FragColor;
+
+        void main() {
+            vec4 color = vec4(layer, 1.0 - layer, 0.5, 1.0);
+            for (int i = 0; i < ALU_ITERATIONS; ++i)
+                color = fract(color * 1.618 + 0.1);
+            vec2 texCoord = gl_FragCoord.xy / 256.0 + layer;
+            for (int i = 0; i < TEXTURE_FETCHES; ++i)
+                color += texture(fillTexture, texCoord + float(i) * 0.37) * 0.1;
+            FragColor = vec4(clamp(color.rgb, 0.0, 1.0), 0.25);
+        #if LATE_Z
+            gl_FragDepth = gl_FragCoord.z;
+        #endif
+        }
+    )";
+
+const ShaderTemplate fill_shader_template = {
+    "fill", fill_vertex_shader_source, fill_fragment_shader_source};
+
+ShaderDefines get_fill_shader_defines(const FillConfig &config) {
+  ShaderDefines defines;
+  defines.set("ALU_ITERATIONS", config.alu_iterations)
+      .set("TEXTURE_FETCHES", config.texture_fetches)
+      .set("LATE_Z", config.depth_mode == DepthMode::late_z);
+  return defines;
+}
+
+// a pattern with detail at every mip level so that fetches cannot be served
+// from a single texel
+static GLuint create_fill_texture() {
+  constexpr int size = 256;
+  std::vector<uint32_t> texels(size * size);
+  for (int y = 0; y < size; ++y)
+    for (int x = 0; x < size; ++x)
+      texels[y * size + x] = ((x ^ y) * 0x010101u) | 0xff000000u;
+
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, texels.data());
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture;
+}
+
+FillPass::~FillPass() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteTextures(1, &texture);
+}
+
+void FillPass::initialize(const FillConfig &fill_config, GLuint program,
+                          int width, int height) {
+  config = fill_config;
+  shader_program = program;
+
+  // the cells of the last row and column stick out of the viewport when the
+  // size does not divide it, clipping keeps the covered area at exactly
+  // width * height per layer
+  int columns = (width + config.triangle_size - 1) / config.triangle_size;
+  int rows = (height + config.triangle_size - 1) / config.triangle_size;
+  std::vector<GLfloat> vertices;
+  vertices.reserve(static_cast<size_t>(columns) * rows * 12);
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      float x0 = 2.0f * column * config.triangle_size / width - 1.0f;
+      float x1 = 2.0f * (column + 1) * config.triangle_size / width - 1.0f;
+      float y0 = 2.0f * row * config.triangle_size / height - 1.0f;
+      float y1 = 2.0f * (row + 1) * config.triangle_size / height - 1.0f;
+      vertices.insert(vertices.end(),
+                      {x0, y0, x1, y0, x1, y1, x0, y0, x1, y1, x0, y1});
+    }
+  }
+  vertices_per_layer = static_cast<GLsizei>(vertices.size() / 2);
+  covered_pixels = static_cast<double>(width) * height * config.overdraw;
+  triangles_per_frame =
+      static_cast<long long>(vertices_per_layer / 3) * config.overdraw;
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat),
+               vertices.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat),
+                        (GLvoid *)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  if (config.texture_fetches > 0)
+    texture = create_fill_texture();
+
+  glUseProgram(shader_program);
+  glUniform1i(glGetUniformLocation(shader_program, "layers"),
+              config.overdraw);
+  glUniform1i(glGetUniformLocation(shader_program, "nearestFirst"),
+              config.depth_mode != DepthMode::back_to_front);
+  glUniform1i(glGetUniformLocation(shader_program, "fillTexture"), 0);
+  glUseProgram(0);
+}
+
+void FillPass::draw() {
+  if (config.depth_mode != DepthMode::off) {
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+  }
+  if (config.blend) {
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  glUseProgram(shader_program);
+  glBindVertexArray(vao);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_per_layer, config.overdraw);
+  glBindVertexArray(0);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+}
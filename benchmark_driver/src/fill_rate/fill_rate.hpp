@@ -0,0 +1,80 @@
+#ifndef FILL_RATE_HPP
+#define FILL_RATE_HPP
+
+#include <glad/glad.h>
+#include <string>
+
+#include "shader_variants/shader_variants.hpp"
+
+// how the layers of a fill pass interact with the depth buffer, every layer
+// covers the whole viewport at a depth of its own
+enum class DepthMode {
+  // no depth test, every layer is shaded and written
+  off,
+  // depth test with the nearest layer drawn first, early z rejects the
+  // fragments of every later layer before they are shaded
+  front_to_back,
+  // depth test with the farthest layer drawn first, every layer passes
+  back_to_front,
+  // front_to_back with a shader that writes gl_FragDepth, which moves the
+  // test after shading so the hidden layers are shaded and then discarded
+  late_z,
+};
+
+bool parse_depth_mode(const std::string &name, DepthMode &mode);
+const char *get_depth_mode_name(DepthMode mode);
+
+struct FillConfig {
+  // each layer is tiled with square cells of this many pixels, two triangles
+  // per cell
+  int triangle_size = 64;
+  // layers drawn on top of each other, the times every pixel is covered
+  int overdraw = 4;
+  DepthMode depth_mode = DepthMode::off;
+  // src alpha / one minus src alpha, every layer reads the framebuffer
+  bool blend = false;
+  // dependent fract / multiply add steps on a vec4 per fragment
+  int alu_iterations = 0;
+  // samples from a mipmapped 256x256 rgba8 texture per fragment
+  int texture_fetches = 0;
+};
+
+// fill_<size>px_x<overdraw>_<depth>[_blend][_alu<n>][_tex<n>]
+std::string get_fill_run_name(const FillConfig &config);
+
+// the fill pass's program, written once, the workload sizes and the depth
+// write are defines so that drivers unroll the loops the way they would for a
+// real material, configurations that differ in anything else share a variant
+extern const ShaderTemplate fill_shader_template;
+ShaderDefines get_fill_shader_defines(const FillConfig &config);
+
+// the geometry and texture for one configuration on the current context,
+// released in the destructor (the context is still current then)
+class FillPass {
+public:
+  ~FillPass();
+
+  // program is fill_shader_template built with the configuration's defines
+  // and outlives the pass
+  void initialize(const FillConfig &config, GLuint program, int width,
+                  int height);
+
+  // sets the depth and blend state, draws every layer with one instanced
+  // draw and restores the defaults, the framebuffer has been cleared
+  void draw();
+
+  // pixels covered per frame counting every layer, what the fill rate is
+  // reported against whether or not they end up shaded
+  double get_covered_pixels() const { return covered_pixels; }
+  long long get_triangles_per_frame() const { return triangles_per_frame; }
+
+private:
+  FillConfig config;
+  GLsizei vertices_per_layer = 0;
+  double covered_pixels = 0.0;
+  long long triangles_per_frame = 0;
+
+  GLuint vao = 0, vbo = 0, texture = 0, shader_program = 0;
+};
+
+#endif // FILL_RATE_HPP
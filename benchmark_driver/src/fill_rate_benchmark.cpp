@@ -0,0 +1,478 @@
+// clang-format off
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "draw_statistics/draw_statistics.hpp"
+#include "fill_rate/fill_rate.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "offscreen_context/offscreen_context.hpp"
+#include "program_cache/program_cache.hpp"
+#include "shader_variants/shader_variants.hpp"
+// clang-format on
+
+// characterizes the pixel side of the pipeline: full screen layers of
+// triangles of a given size, drawn with overdraw, depth testing, blending and
+// a fragment workload that every flag takes a list of, the runs are the
+// cartesian product, the vertex work is kept small so the fill rate decides
+// the frame time
+
+struct FillSweepOptions {
+  std::vector<int> triangle_sizes = {64};
+  std::vector<int> overdraws = {4};
+  std::vector<DepthMode> depth_modes = {DepthMode::off};
+  std::vector<bool> blends = {false};
+  std::vector<int> alu_iterations = {0};
+  std::vector<int> texture_fetches = {0};
+  int width = 1920;
+  int height = 1080;
+};
+
+static void print_usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--size <pixels>[,...]] [--overdraw <layers>[,...]]"
+               " [--depth <mode>[,...]|all] [--blend off|on|off,on]"
+               " [--alu <iterations>[,...]] [--texture-fetches <n>[,...]]"
+               " [--resolution <width>x<height>] [--headless]"
+               " [--frames <num_frames>] [--warmup <num_frames>]"
+               " [--output <results.json|csv>] [--draw-stats]"
+               " [--program-cache <dir>]\n"
+               "depth modes: off, front_to_back, back_to_front, late_z\n";
+}
+
+static std::vector<std::string> split(const std::string &value,
+                                      char separator) {
+  std::vector<std::string> parts;
+  std::stringstream stream(value);
+  std::string part;
+  while (std::getline(stream, part, separator))
+    parts.push_back(part);
+  return parts;
+}
+
+// comma separated integers of at least minimum
+static bool parse_int_list(const std::string &flag, const std::string &value,
+                           int minimum, std::vector<int> &values) {
+  std::vector<int> parsed;
+  for (const std::string &part : split(value, ',')) {
+    char *end = nullptr;
+    long number = std::strtol(part.c_str(), &end, 10);
+    if (part.empty() || *end != '\0' || number < minimum ||
+        number > std::numeric_limits<int>::max()) {
+      std::cerr << "Error: " << flag << " expects integers of at least "
+                << minimum << ", got " << part << "\n";
+      return false;
+    }
+    parsed.push_back(static_cast<int>(number));
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: " << flag << " requires a value.\n";
+    return false;
+  }
+  values = parsed;
+  return true;
+}
+
+static bool parse_depth_modes(const std::string &value,
+                              std::vector<DepthMode> &modes) {
+  std::vector<DepthMode> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(),
+                    {DepthMode::off, DepthMode::front_to_back,
+                     DepthMode::back_to_front, DepthMode::late_z});
+      continue;
+    }
+    DepthMode mode;
+    if (!parse_depth_mode(name, mode)) {
+      std::cerr << "Error: unknown depth mode: " << name << "\n";
+      return false;
+    }
+    parsed.push_back(mode);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no depth modes given\n";
+    return false;
+  }
+  modes = parsed;
+  return true;
+}
+
+static bool parse_blends(const std::string &value, std::vector<bool> &blends) {
+  std::vector<bool> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name != "off" && name != "on") {
+      std::cerr << "Error: --blend expects off or on, got " << name << "\n";
+      return false;
+    }
+    parsed.push_back(name == "on");
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: --blend requires a value.\n";
+    return false;
+  }
+  blends = parsed;
+  return true;
+}
+
+static bool parse_fill_options(int argc, char *argv[],
+                               FillSweepOptions &options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Error: unknown argument or missing value: " << arg << "\n";
+      return false;
+    }
+    std::string value = argv[++i];
+    bool parsed = true;
+    if (arg == "--size") {
+      parsed = parse_int_list(arg, value, 1, options.triangle_sizes);
+    } else if (arg == "--overdraw") {
+      parsed = parse_int_list(arg, value, 1, options.overdraws);
+    } else if (arg == "--depth") {
+      parsed = parse_depth_modes(value, options.depth_modes);
+    } else if (arg == "--blend") {
+      parsed = parse_blends(value, options.blends);
+    } else if (arg == "--alu") {
+      parsed = parse_int_list(arg, value, 0, options.alu_iterations);
+    } else if (arg == "--texture-fetches") {
+      parsed = parse_int_list(arg, value, 0, options.texture_fetches);
+    } else if (arg == "--resolution") {
+      std::vector<std::string> sides = split(value, 'x');
+      if (sides.size() != 2 ||
+          (options.width = std::atoi(sides[0].c_str())) <= 0 ||
+          (options.height = std::atoi(sides[1].c_str())) <= 0) {
+        std::cerr << "Error: --resolution expects <width>x<height>\n";
+        return false;
+      }
+    } else {
+      std::cerr << "Error: unknown argument: " << arg << "\n";
+      return false;
+    }
+    if (!parsed)
+      return false;
+  }
+  return true;
+}
+
+static std::vector<FillConfig> expand_fill_sweep(
+    const FillSweepOptions &options) {
+  std::vector<FillConfig> configs;
+  for (int triangle_size : options.triangle_sizes)
+    for (int overdraw : options.overdraws)
+      for (DepthMode depth_mode : options.depth_modes)
+        for (bool blend : options.blends)
+          for (int alu_iterations : options.alu_iterations)
+            for (int texture_fetches : options.texture_fetches)
+              configs.push_back({triangle_size, overdraw, depth_mode, blend,
+                                 alu_iterations, texture_fetches});
+  return configs;
+}
+
+struct FillResult {
+  FillConfig config;
+  std::string run_name;
+  bool succeeded = false;
+  long long triangles_per_frame = 0;
+  SampleSummary cpu_ms;
+  bool has_gpu_timing = false;
+  SampleSummary gpu_ms;
+  // covered pixels over the median gpu frame time, the cpu one without gpu
+  // timing
+  double gpixels_per_s = 0.0;
+  std::vector<std::pair<std::string, SampleSummary>> metrics;
+};
+
+static void measure_fill(const FillConfig &config, GLuint program, int width,
+                         int height,
+                         const HeadlessOptions &headless,
+                         const FrameTimerOptions &timer_options,
+                         OffscreenContext &offscreen, GLFWwindow *window,
+                         FillResult &result) {
+  if (program == 0)
+    return;
+  FillPass pass;
+  pass.initialize(config, program, width, height);
+  result.triangles_per_frame = pass.get_triangles_per_frame();
+
+  FrameTimer frame_timer(timer_options.warmup_frames);
+  std::unique_ptr<DrawStatistics> draw_statistics;
+  if (timer_options.draw_statistics)
+    draw_statistics = std::make_unique<DrawStatistics>();
+  for (int frame = 0; frame < headless.num_frames; ++frame) {
+    frame_timer.begin_frame();
+    if (window != nullptr)
+      glfwPollEvents();
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClearDepth(1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (draw_statistics)
+      draw_statistics->begin(frame_timer);
+    pass.draw();
+    if (draw_statistics)
+      draw_statistics->end();
+
+    if (window == nullptr)
+      offscreen.present();
+    else
+      glfwSwapBuffers(window);
+    frame_timer.end_frame();
+  }
+  if (draw_statistics)
+    draw_statistics->finish();
+  frame_timer.finish();
+
+  result.succeeded = true;
+  result.cpu_ms = summarize(frame_timer.get_cpu_frame_times());
+  result.has_gpu_timing = frame_timer.has_gpu_timing();
+  result.gpu_ms = summarize(frame_timer.get_gpu_frame_times());
+  for (const FrameTimer::Metric &metric : frame_timer.get_metrics())
+    result.metrics.push_back({metric.name, summarize(metric.values)});
+  double frame_ms = result.has_gpu_timing && result.gpu_ms.count > 0
+                        ? result.gpu_ms.p50
+                        : result.cpu_ms.p50;
+  if (frame_ms > 0.0)
+    result.gpixels_per_s = pass.get_covered_pixels() / (frame_ms * 1e6);
+
+  frame_timer.print_summary(std::cout, result.run_name);
+  std::ios_base::fmtflags flags = std::cout.flags();
+  std::streamsize precision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(3) << "  fill rate "
+            << result.gpixels_per_s << " Gpixels/s, "
+            << result.triangles_per_frame / (frame_ms * 1e3)
+            << " Mtriangles/s\n";
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+}
+
+static bool write_fill_json(std::ostream &out,
+                            const std::vector<FillResult> &results,
+                            int width, int height, int warmup_frames,
+                            int num_frames) {
+  out << "{\n";
+  out << "  \"renderer\": \""
+      << json_escape(reinterpret_cast<const char *>(glGetString(GL_RENDERER)))
+      << "\",\n";
+  out << "  \"width\": " << width << ",\n";
+  out << "  \"height\": " << height << ",\n";
+  out << "  \"warmup_frames\": " << warmup_frames << ",\n";
+  out << "  \"frames\": " << num_frames << ",\n";
+  out << "  \"runs\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const FillResult &result = results[i];
+    const FillConfig &config = result.config;
+    out << (i == 0 ? "\n" : ",\n") << "    {\"run\": \"" << result.run_name
+        << "\", \"size\": " << config.triangle_size
+        << ", \"overdraw\": " << config.overdraw << ", \"depth\": \""
+        << get_depth_mode_name(config.depth_mode)
+        << "\", \"blend\": " << (config.blend ? "true" : "false")
+        << ", \"alu\": " << config.alu_iterations
+        << ", \"texture_fetches\": " << config.texture_fetches
+        << ", \"status\": \"" << (result.succeeded ? "ok" : "failed") << '"';
+    if (result.succeeded) {
+      out << ", \"triangles\": " << result.triangles_per_frame
+          << ", \"gpixels_per_s\": " << result.gpixels_per_s;
+      out << ",\n     \"cpu_ms\": ";
+      write_json_summary(out, result.cpu_ms);
+      out << ",\n     \"gpu_ms\": ";
+      if (result.has_gpu_timing)
+        write_json_summary(out, result.gpu_ms);
+      else
+        out << "null";
+      for (const auto &[name, summary] : result.metrics) {
+        out << ",\n     \"" << json_escape(name) << "\": ";
+        write_json_summary(out, summary);
+      }
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+// the mean of every metric, runs without one leave its column empty
+static bool write_fill_csv(std::ostream &out,
+                           const std::vector<FillResult> &results) {
+  std::vector<std::string> metric_names;
+  for (const FillResult &result : results)
+    for (const auto &metric : result.metrics)
+      if (std::find(metric_names.begin(), metric_names.end(), metric.first) ==
+          metric_names.end())
+        metric_names.push_back(metric.first);
+
+  out << "run,size,overdraw,depth,blend,alu,texture_fetches,status,triangles,"
+         "gpixels_per_s,cpu_ms_mean,cpu_ms_p50,cpu_ms_p95,gpu_ms_mean,"
+         "gpu_ms_p50,gpu_ms_p95";
+  for (const std::string &name : metric_names)
+    out << ',' << name << "_mean";
+  out << '\n';
+
+  for (const FillResult &result : results) {
+    const FillConfig &config = result.config;
+    out << result.run_name << ',' << config.triangle_size << ','
+        << config.overdraw << ',' << get_depth_mode_name(config.depth_mode)
+        << ',' << (config.blend ? 1 : 0) << ',' << config.alu_iterations
+        << ',' << config.texture_fetches << ','
+        << (result.succeeded ? "ok" : "failed");
+    if (!result.succeeded) {
+      out << std::string(8 + metric_names.size(), ',') << '\n';
+      continue;
+    }
+    out << ',' << result.triangles_per_frame << ',' << result.gpixels_per_s
+        << ',' << result.cpu_ms.mean << ',' << result.cpu_ms.p50 << ','
+        << result.cpu_ms.p95 << ',';
+    if (result.has_gpu_timing)
+      out << result.gpu_ms.mean << ',' << result.gpu_ms.p50 << ','
+          << result.gpu_ms.p95;
+    else
+      out << ",,";
+    for (const std::string &name : metric_names) {
+      out << ',';
+      for (const auto &metric : result.metrics)
+        if (metric.first == name)
+          out << metric.second.mean;
+    }
+    out << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+// one row per run, the extension picks the format like write_sweep_results
+static bool write_fill_results(const std::string &path,
+                               const std::vector<FillResult> &results,
+                               const FillSweepOptions &options,
+                               int warmup_frames, int num_frames) {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open " << path << " for writing" << std::endl;
+    return false;
+  }
+  file << std::setprecision(6);
+
+  bool is_csv =
+      path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+  bool written = is_csv ? write_fill_csv(file, results)
+                        : write_fill_json(file, results, options.width,
+                                          options.height, warmup_frames,
+                                          num_frames);
+  if (!written)
+    std::cerr << "Failed to write results to " << path << std::endl;
+  return written;
+}
+
+int main(int argc, char *argv[]) {
+  HeadlessOptions headless;
+  FrameTimerOptions timer_options;
+  ProgramCacheOptions program_cache;
+  FillSweepOptions options;
+  if (!parse_headless_options(argc, argv, headless) ||
+      !parse_frame_timer_options(argc, argv, timer_options) ||
+      !parse_program_cache_options(argc, argv, program_cache) ||
+      !parse_fill_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  // every pass runs a fixed number of frames, windowed or not
+  clamp_warmup_frames(timer_options, headless.num_frames);
+  set_program_cache_directory(program_cache.directory);
+
+  // one context for every run, a fill pass leaves no state behind
+  GLFWwindow *window = nullptr;
+  OffscreenContext offscreen(options.width, options.height, 3, 3);
+  if (headless.enabled) {
+    if (!offscreen.initialize()) {
+      std::cerr << "Failed to create offscreen context" << std::endl;
+      return 1;
+    }
+  } else {
+    if (!glfwInit()) {
+      std::cerr << "Failed to initialize GLFW" << std::endl;
+      return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    window = glfwCreateWindow(options.width, options.height,
+                              "fill rate benchmark", nullptr, nullptr);
+    if (!window) {
+      std::cerr << "Failed to create GLFW window" << std::endl;
+      glfwTerminate();
+      return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      std::cerr << "Failed to initialize GLAD" << std::endl;
+      glfwTerminate();
+      return 1;
+    }
+  }
+
+  std::vector<FillConfig> configs = expand_fill_sweep(options);
+  std::vector<FillResult> results;
+  {
+    // every configuration's program is built up front in one batch, the
+    // configurations that only differ outside the shader share one, a
+    // variant that fails to build fails its configurations
+    ShaderVariantSet shader_variants;
+    std::vector<size_t> config_variants;
+    for (const FillConfig &config : configs)
+      config_variants.push_back(shader_variants.add(
+          fill_shader_template, get_fill_shader_defines(config)));
+    auto build_start = std::chrono::steady_clock::now();
+    shader_variants.build();
+    double build_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - build_start)
+                          .count();
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3) << "Built "
+              << shader_variants.size() << " shader variants for "
+              << configs.size() << " configurations in " << build_ms
+              << " ms"
+              << (shader_variants.used_parallel_compile()
+                      ? " (KHR_parallel_shader_compile)"
+                      : "")
+              << '\n';
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    shader_variants.print_stats(std::cout);
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+      FillResult result;
+      result.config = configs[i];
+      result.run_name = get_fill_run_name(configs[i]);
+      measure_fill(configs[i],
+                   shader_variants.get_program(config_variants[i]),
+                   options.width, options.height, headless, timer_options,
+                   offscreen, window, result);
+      results.push_back(result);
+    }
+  }
+
+  bool succeeded = true;
+  if (!timer_options.output_path.empty())
+    succeeded = write_fill_results(timer_options.output_path, results,
+                                   options, timer_options.warmup_frames,
+                                   headless.num_frames);
+
+  if (window != nullptr) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+  }
+  for (const FillResult &result : results)
+    succeeded = succeeded && result.succeeded;
+  return succeeded ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// clang-format off
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "frame_timer/frame_timer.hpp"
+#include "scene/scene.hpp"
+#include "thread_pool/thread_pool.hpp"
+// clang-format on
+
+// compares the serial generate_model_matrices loop against the parallel
+// batched generator on the same four cube layout the driver uses, no gl
+// context is needed
+
+static void print_row(const char *label, const SampleSummary &summary,
+                      int num_objects) {
+  std::cout << std::fixed << std::setprecision(3) << "  " << label << " min "
+            << summary.min << " mean " << summary.mean << " p50 "
+            << summary.p50 << " max " << summary.max << " ms ("
+            << std::setprecision(2) << num_objects / (summary.p50 * 1000.0)
+            << " M matrices/s)\n";
+}
+
+int main(int argc, char *argv[]) {
+  int num_objects = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int repetitions = argc > 2 ? std::atoi(argv[2]) : 20;
+  if (num_objects <= 0 || repetitions <= 0) {
+    std::cerr << "Usage: " << argv[0] << " [num_objects] [repetitions]\n";
+    return 1;
+  }
+
+  ThreadPool pool;
+  std::cout << "Generating " << num_objects << " matrices, " << repetitions
+            << " repetitions, " << pool.get_num_threads() + 1
+            << " threads\n";
+
+  int per_cube = num_objects / 4;
+  const glm::vec3 origins[4] = {
+      glm::vec3(1.5f, 1.5f, -1.0f), glm::vec3(-1.5f, 1.5f, -1.0f),
+      glm::vec3(-1.5f, -1.5f, -1.0f), glm::vec3(1.5f, -1.5f, -1.0f)};
+
+  std::vector<glm::mat4> serial(static_cast<size_t>(per_cube) * 4);
+  std::vector<glm::mat4> parallel(serial.size());
+  std::vector<double> serial_times, parallel_times;
+
+  for (int repetition = 0; repetition < repetitions; ++repetition) {
+    auto start = std::chrono::steady_clock::now();
+    for (int cube = 0; cube < 4; ++cube)
+      generate_model_matrices(&serial[cube * per_cube], per_cube,
+                              origins[cube]);
+    auto middle = std::chrono::steady_clock::now();
+    for (int cube = 0; cube < 4; ++cube)
+      generate_model_matrices_parallel(pool, &parallel[cube * per_cube],
+                                       per_cube, origins[cube]);
+    auto end = std::chrono::steady_clock::now();
+
+    serial_times.push_back(
+        std::chrono::duration<double, std::milli>(middle - start).count());
+    parallel_times.push_back(
+        std::chrono::duration<double, std::milli>(end - middle).count());
+  }
+
+  for (size_t i = 0; i < serial.size(); ++i) {
+    if (serial[i] != parallel[i]) {
+      std::cerr << "Mismatch at object " << i << std::endl;
+      return 1;
+    }
+  }
+
+  print_row("serial  ", summarize(serial_times), per_cube * 4);
+  print_row("parallel", summarize(parallel_times), per_cube * 4);
+  return 0;
+}
@@ -0,0 +1,634 @@
+// clang-format off
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dirty_tracker/dirty_tracker.hpp"
+#include "draw_statistics/draw_statistics.hpp"
+#include "frame_capture/frame_capture.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "offscreen_context/offscreen_context.hpp"
+#include "program_cache/program_cache.hpp"
+#include "scene/scene.hpp"
+#include "shader_utils/shader_utils.hpp"
+#include "simulation/simulation.hpp"
+#include "sweep/sweep.hpp"
+#include "transform_strategy/transform_strategy.hpp"
+// clang-format on
+
+struct DriverOptions {
+  SweepOptions sweep;
+  // vertical, narrowing it leaves part of the scene outside the frustum
+  float field_of_view = 80.0f;
+  // ticks per second of a simulation thread, 0 simulates back to back
+  double simulation_rate = 0.0;
+  bool list_strategies = false;
+};
+
+static void print_usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--strategy <name>[,<name>...]|all]"
+               " [--objects <n>[,<n>...]|<first>:<last>[:<factor>]]"
+               " [--width <pixels>] [--height <pixels>]"
+               " [--resolution <width>x<height>[,...]] [--list-strategies]"
+               " [--animate] [--upload <method>[,<method>...]|all]"
+               " [--fov <degrees>]"
+               " [--encoding <encoding>[,<encoding>...]|all]"
+               " [--vertex-layout <layout>[,<layout>...]|all]"
+               " [--mesh triangle|sphere|grid|cube[,...]|all]"
+               " [--mesh-triangles <n>[,<n>...]|<first>:<last>[:<factor>]]"
+               " [--index-type u16|u32[,...]|all]"
+               " [--threading single|simulation[,...]|all]"
+               " [--simulation-rate <hz>] [--moving <percent>[,...]]"
+               " [--headless] [--frames <num_frames>] [--warmup <num_frames>]"
+               " [--output <results.json|csv>] [--draw-stats]"
+               " [--program-cache <dir>] [--fixed-timestep]"
+               " [--capture <dir>] [--capture-every <frames>]\n";
+}
+
+static bool parse_driver_options(int argc, char *argv[],
+                                 DriverOptions &options) {
+  SweepOptions &sweep = options.sweep;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--list-strategies") {
+      options.list_strategies = true;
+      continue;
+    }
+    if (arg == "--animate") {
+      sweep.dynamic_transforms = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "Error: unknown argument or missing value: " << arg << "\n";
+      return false;
+    }
+    std::string value = argv[++i];
+    bool parsed = true;
+    if (arg == "--strategy") {
+      parsed = parse_strategy_names(value, sweep.strategy_names);
+    } else if (arg == "--objects") {
+      parsed = parse_object_counts(value, sweep.object_counts);
+    } else if (arg == "--width" || arg == "--height") {
+      // a single resolution, kept for runs that only change one side
+      int &side = arg == "--width" ? sweep.resolutions[0].width
+                                   : sweep.resolutions[0].height;
+      side = std::atoi(value.c_str());
+      sweep.resolutions.resize(1);
+      if (side <= 0) {
+        std::cerr << "Error: resolution must be positive.\n";
+        return false;
+      }
+    } else if (arg == "--resolution") {
+      parsed = parse_resolutions(value, sweep.resolutions);
+    } else if (arg == "--upload") {
+      parsed = parse_upload_methods(value, sweep.upload_methods);
+    } else if (arg == "--encoding") {
+      parsed = parse_transform_encodings(value, sweep.transform_encodings);
+    } else if (arg == "--vertex-layout") {
+      parsed = parse_vertex_layouts(value, sweep.vertex_layouts);
+    } else if (arg == "--mesh") {
+      parsed = parse_mesh_shapes(value, sweep.mesh_shapes);
+    } else if (arg == "--mesh-triangles") {
+      parsed = parse_mesh_triangle_counts(value, sweep.mesh_triangle_counts);
+    } else if (arg == "--index-type") {
+      parsed = parse_index_types(value, sweep.index_types);
+    } else if (arg == "--threading") {
+      parsed = parse_threading_modes(value, sweep.simulation_threads);
+    } else if (arg == "--simulation-rate") {
+      options.simulation_rate = std::atof(value.c_str());
+      if (options.simulation_rate < 0.0) {
+        std::cerr << "Error: --simulation-rate must not be negative.\n";
+        return false;
+      }
+    } else if (arg == "--moving") {
+      parsed = parse_moving_percents(value, sweep.moving_percents);
+    } else if (arg == "--fov") {
+      options.field_of_view = std::atof(value.c_str());
+      if (options.field_of_view <= 0.0f || options.field_of_view >= 180.0f) {
+        std::cerr << "Error: --fov must be between 0 and 180 degrees.\n";
+        return false;
+      }
+    } else {
+      std::cerr << "Error: unknown argument: " << arg << "\n";
+      return false;
+    }
+    if (!parsed)
+      return false;
+  }
+  // the simulation thread produces every matrix each tick
+  bool simulation_thread =
+      std::find(sweep.simulation_threads.begin(),
+                sweep.simulation_threads.end(),
+                true) != sweep.simulation_threads.end();
+  if (!sweep.moving_percents.empty() && simulation_thread) {
+    std::cerr << "Error: --moving cannot be combined with a simulation "
+                 "thread.\n";
+    return false;
+  }
+  return true;
+}
+
+static double milliseconds_between(std::chrono::steady_clock::time_point start,
+                                   std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static std::string gl_string(GLenum name) {
+  const GLubyte *value = glGetString(name);
+  return value ? reinterpret_cast<const char *>(value) : "unknown";
+}
+
+struct RunSettings {
+  HeadlessOptions headless;
+  FrameTimerOptions timer_options;
+  // each run captures into a subdirectory named after it
+  FrameCaptureOptions capture_options;
+  float field_of_view = 80.0f;
+  double simulation_rate = 0.0;
+  // sweeps stop every run after headless.num_frames frames even when
+  // windowed, a single windowed run goes on until the window is closed
+  bool fixed_frame_count = false;
+  // a single run writes its per frame samples to the output path, a sweep
+  // writes one summary row per run there instead
+  bool write_frame_results = false;
+};
+
+// dirty objects at most this many clean ones apart are uploaded as one range,
+// a few unchanged matrices cost less than another upload call
+static constexpr size_t dirty_range_gap = 16;
+
+// renders one configuration with the context already current, everything the
+// strategy creates is released before returning
+static void measure_configuration(const RunConfig &config, const Scene &scene,
+                                  ThreadPool &pool, const RunSettings &settings,
+                                  OffscreenContext &offscreen,
+                                  GLFWwindow *window, RunResult &result) {
+  result.renderer = gl_string(GL_RENDERER);
+  result.version = gl_string(GL_VERSION);
+
+  std::unique_ptr<TransformStrategy> strategy =
+      create_strategy(config.strategy_name);
+  StrategyOptions strategy_options = config.strategy_options;
+  strategy_options.thread_pool = &pool;
+  if (!strategy->supports_transform_encoding(
+          strategy_options.transform_encoding)) {
+    std::cerr << config.strategy_name << " only stores mat4 transforms"
+              << std::endl;
+    return;
+  }
+  if (!strategy->supports_vertex_layout(strategy_options.vertex_layout)) {
+    std::cerr << config.strategy_name << " only draws aos_float vertices"
+              << std::endl;
+    return;
+  }
+  if (!strategy->supports_object_mesh(strategy_options.object_mesh.shape)) {
+    std::cerr << config.strategy_name << " only draws the triangle"
+              << std::endl;
+    return;
+  }
+  if (strategy->animates_on_gpu() &&
+      (config.simulation_thread || config.track_changes)) {
+    std::cerr << config.strategy_name
+              << " animates on the gpu, without a simulation thread or "
+                 "change tracking"
+              << std::endl;
+    return;
+  }
+  if (config.track_changes && !strategy->supports_change_tracking()) {
+    std::cerr << config.strategy_name
+              << " uploads every matrix each frame, without change tracking"
+              << std::endl;
+    return;
+  }
+  reset_program_build_stats();
+  auto initialize_start = std::chrono::steady_clock::now();
+  if (!strategy->initialize(scene, strategy_options)) {
+    std::cerr << "Failed to initialize strategy " << config.strategy_name
+              << std::endl;
+    return;
+  }
+  StartupTimes &startup = result.startup;
+  startup.initialize_ms = milliseconds_between(
+      initialize_start, std::chrono::steady_clock::now());
+  const ProgramBuildStats &build_stats = get_program_build_stats();
+  startup.compile_ms = build_stats.compile_ms;
+  startup.link_ms = build_stats.link_ms;
+  startup.cache_load_ms = build_stats.cache_load_ms;
+  startup.programs_compiled = build_stats.programs_compiled;
+  startup.programs_loaded = build_stats.programs_loaded;
+
+  FrameUniforms uniforms;
+  uniforms.projection = glm::perspective(
+      glm::radians(settings.field_of_view),
+      (float)config.resolution.width / config.resolution.height, 0.1f, 10.0f);
+
+  // Main loop, headless runs stop after a fixed number of frames, they and
+  // runs with a fixed timestep drive the camera and the animation from the
+  // frame index so every run renders the same frames
+  bool fixed_clock =
+      settings.headless.enabled || settings.capture_options.fixed_timestep;
+  bool dynamic_transforms = config.strategy_options.dynamic_transforms;
+  int frame = 0;
+  FrameTimer frame_timer(settings.timer_options.warmup_frames);
+  std::unique_ptr<DrawStatistics> draw_statistics;
+  if (settings.timer_options.draw_statistics)
+    draw_statistics = std::make_unique<DrawStatistics>();
+  std::unique_ptr<FrameCapture> frame_capture;
+  if (!settings.capture_options.directory.empty()) {
+    FrameCaptureOptions capture_options = settings.capture_options;
+    capture_options.directory =
+        (std::filesystem::path(capture_options.directory) / result.run_name)
+            .string();
+    frame_capture = std::make_unique<FrameCapture>(
+        capture_options, config.resolution.width, config.resolution.height);
+    if (!frame_capture->initialize())
+      return;
+  }
+  // fixed clock runs step the simulation by a fixed 1/60 s per tick,
+  // matching the single threaded loop's frame / 60
+  std::unique_ptr<SimulationThread> simulation;
+  if (dynamic_transforms && config.simulation_thread)
+    simulation = std::make_unique<SimulationThread>(
+        scene, pool, settings.simulation_rate, fixed_clock);
+  uint64_t last_sequence = 0;
+  // runs tracking changes keep every object's current matrix here, animate an
+  // evenly spread moving_percent of the objects and hand the strategy only
+  // the ranges that changed
+  bool track_changes = dynamic_transforms && config.track_changes;
+  std::vector<glm::mat4> current_matrices;
+  std::vector<uint32_t> moving_objects;
+  DirtyTracker dirty_objects;
+  std::vector<DirtyRange> dirty_ranges;
+  if (track_changes) {
+    current_matrices.assign(scene.model_matrices.begin(),
+                            scene.model_matrices.end());
+    uint64_t num_objects = scene.num_objects;
+    uint64_t num_moving =
+        std::llround(num_objects * config.moving_percent / 100.0);
+    for (uint64_t i = 0; i < num_objects; ++i)
+      if ((i + 1) * num_moving / num_objects != i * num_moving / num_objects)
+        moving_objects.push_back(static_cast<uint32_t>(i));
+    dirty_objects.resize(scene.num_objects);
+  }
+  while (window == nullptr || !glfwWindowShouldClose(window)) {
+    if (settings.fixed_frame_count && frame >= settings.headless.num_frames)
+      break;
+
+    auto frame_start = std::chrono::steady_clock::now();
+    frame_timer.begin_frame();
+
+    if (window != nullptr)
+      glfwPollEvents();
+
+    float radius = 8.0f; // Distance from the origin
+    float time = fixed_clock ? frame / 60.0f : glfwGetTime();
+    float cam_x = cos(time) * radius;
+    float cam_z = sin(time) * radius;
+    glm::vec3 camera_position = glm::vec3(cam_x, 1.0f, cam_z);
+    glm::vec3 target = glm::vec3(0.0f, 0.0f, 0.0f); // Looking at the origin
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);     // Up direction
+    uniforms.view = glm::lookAt(camera_position, target, up);
+
+    // Regenerate every matrix, the time spent writing them is reported apart
+    // from the time spent getting them to the gpu, latency_ms runs from the
+    // start of generating the matrices to the present that shows them
+    std::chrono::steady_clock::time_point simulation_start;
+    if (simulation) {
+      // the matrices were generated on the simulation thread, this thread
+      // only copies the latest tick into the strategy
+      auto upload_start = std::chrono::steady_clock::now();
+      bool fresh = false;
+      const TransformSnapshot &snapshot = simulation->acquire_latest(fresh);
+      glm::mat4 *model_matrices = strategy->begin_transform_update();
+      const glm::mat4 *source = snapshot.model_matrices.data();
+      if (model_matrices != nullptr)
+        pool.parallel_for(snapshot.model_matrices.size(),
+                          [&](size_t first, size_t last) {
+                            std::copy(source + first, source + last,
+                                      model_matrices + first);
+                          });
+      strategy->end_transform_update();
+      auto upload_end = std::chrono::steady_clock::now();
+      simulation_start = snapshot.simulation_start;
+
+      frame_timer.record("upload_ms",
+                         milliseconds_between(upload_start, upload_end));
+      frame_timer.record("snapshot_age_ms",
+                         milliseconds_between(snapshot.simulation_end,
+                                              upload_start));
+      if (fresh) {
+        frame_timer.record("generate_ms",
+                           milliseconds_between(snapshot.simulation_start,
+                                                snapshot.simulation_end));
+        // ticks published and overwritten before this thread took one
+        if (last_sequence != 0)
+          frame_timer.record(
+              "skipped_ticks",
+              static_cast<double>(snapshot.sequence - last_sequence - 1));
+        last_sequence = snapshot.sequence;
+      }
+    } else if (track_changes) {
+      auto generate_start = std::chrono::steady_clock::now();
+      animate_model_matrices(pool, scene, time, moving_objects,
+                             current_matrices.data());
+      for (uint32_t object : moving_objects)
+        dirty_objects.mark(object);
+      dirty_ranges.clear();
+      dirty_objects.collect_ranges(dirty_ranges, dirty_range_gap);
+      dirty_objects.clear();
+      auto generate_end = std::chrono::steady_clock::now();
+      size_t uploaded_bytes =
+          strategy->update_transforms(current_matrices, dirty_ranges);
+      auto upload_end = std::chrono::steady_clock::now();
+      simulation_start = generate_start;
+
+      frame_timer.record("generate_ms",
+                         milliseconds_between(generate_start, generate_end));
+      frame_timer.record("upload_ms",
+                         milliseconds_between(generate_end, upload_end));
+      frame_timer.record("uploaded_bytes",
+                         static_cast<double>(uploaded_bytes));
+      frame_timer.record("upload_ranges",
+                         static_cast<double>(dirty_ranges.size()));
+    } else if (dynamic_transforms && strategy->animates_on_gpu()) {
+      // generate_ms is only the cpu cost of issuing the pass, its gpu time is
+      // the strategy's animate_gpu_ms, the time uniform is all that is sent
+      auto generate_start = std::chrono::steady_clock::now();
+      strategy->animate_transforms(time);
+      auto generate_end = std::chrono::steady_clock::now();
+      simulation_start = generate_start;
+
+      frame_timer.record("generate_ms",
+                         milliseconds_between(generate_start, generate_end));
+      frame_timer.record("uploaded_bytes", sizeof(float));
+    } else if (dynamic_transforms) {
+      auto upload_start = std::chrono::steady_clock::now();
+      glm::mat4 *model_matrices = strategy->begin_transform_update();
+      auto generate_start = std::chrono::steady_clock::now();
+      if (model_matrices != nullptr)
+        animate_model_matrices(pool, scene, time, model_matrices);
+      auto generate_end = std::chrono::steady_clock::now();
+      strategy->end_transform_update();
+      auto upload_end = std::chrono::steady_clock::now();
+      simulation_start = generate_start;
+
+      frame_timer.record("generate_ms",
+                         milliseconds_between(generate_start, generate_end));
+      frame_timer.record("upload_ms",
+                         milliseconds_between(upload_start, generate_start) +
+                             milliseconds_between(generate_end, upload_end));
+    }
+
+    // Clear the screen
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (draw_statistics)
+      draw_statistics->begin(frame_timer);
+    auto draw_start = std::chrono::steady_clock::now();
+    strategy->draw(uniforms);
+    auto draw_end = std::chrono::steady_clock::now();
+    if (draw_statistics)
+      draw_statistics->end();
+    double draw_ms = milliseconds_between(draw_start, draw_end);
+    frame_timer.record("draw_ms", draw_ms);
+    // cpu submission cost of a single draw, comparable across strategies that
+    // draw the scene in one call, in batches or one object at a time
+    frame_timer.record("draw_us_per_draw",
+                       draw_ms * 1000.0 / strategy->get_draws_per_frame());
+    strategy->record_metrics(frame_timer);
+    if (strategy->has_failed()) {
+      std::cerr << config.strategy_name << ": an upload failed, ending the run"
+                << std::endl;
+      return;
+    }
+
+    if (frame_capture) {
+      auto capture_start = std::chrono::steady_clock::now();
+      frame_capture->capture(frame);
+      auto capture_end = std::chrono::steady_clock::now();
+      frame_timer.record("capture_ms",
+                         milliseconds_between(capture_start, capture_end));
+    }
+
+    // Swap buffers
+    if (window == nullptr)
+      offscreen.present();
+    else
+      glfwSwapBuffers(window);
+    if (dynamic_transforms) {
+      auto present_end = std::chrono::steady_clock::now();
+      frame_timer.record("latency_ms",
+                         milliseconds_between(simulation_start, present_end));
+    }
+
+    frame_timer.end_frame();
+    if (frame == 0)
+      startup.first_frame_ms =
+          milliseconds_between(frame_start, std::chrono::steady_clock::now());
+    ++frame;
+  }
+
+  // Report startup and frame times
+  std::ios_base::fmtflags flags = std::cout.flags();
+  std::streamsize precision = std::cout.precision();
+  std::cout << std::fixed << std::setprecision(3) << "Startup: context "
+            << startup.context_ms << " ms, initialize "
+            << startup.initialize_ms << " ms (compile " << startup.compile_ms
+            << " ms, link " << startup.link_ms << " ms, cache load "
+            << startup.cache_load_ms << " ms, " << startup.programs_compiled
+            << " compiled, " << startup.programs_loaded
+            << " from cache), first frame " << startup.first_frame_ms
+            << " ms\n";
+  std::cout.flags(flags);
+  std::cout.precision(precision);
+  simulation.reset();
+  if (draw_statistics)
+    draw_statistics->finish();
+  strategy->record_run_values(frame_timer);
+  frame_timer.finish();
+  if (frame_capture) {
+    frame_capture->finish();
+    std::cout << "Captured " << frame_capture->get_frames_captured()
+              << " frames (" << frame_capture->get_stalls()
+              << " waited for an earlier readback)\n";
+  }
+  frame_timer.print_summary(std::cout, result.run_name);
+  if (settings.write_frame_results)
+    frame_timer.write_results(settings.timer_options.output_path,
+                              result.run_name);
+
+  result.succeeded = true;
+  result.cpu_ms = summarize(frame_timer.get_cpu_frame_times());
+  result.has_gpu_timing = frame_timer.has_gpu_timing();
+  result.gpu_ms = summarize(frame_timer.get_gpu_frame_times());
+  for (const FrameTimer::Metric &metric : frame_timer.get_metrics())
+    result.metrics.push_back({metric.name, summarize(metric.values)});
+  result.run_values = frame_timer.get_run_values();
+}
+
+// every configuration gets a context of its own so that no buffers, programs,
+// driver caches or fragmentation carry over from the previous run
+static void run_configuration(const RunConfig &config, const Scene &scene,
+                              ThreadPool &pool, const RunSettings &settings,
+                              RunResult &result) {
+  // strategies check the version they need themselves, asking for 3.3 core
+  // gets the highest core version the driver supports
+  auto context_start = std::chrono::steady_clock::now();
+  GLFWwindow *window = nullptr;
+  OffscreenContext offscreen(config.resolution.width,
+                             config.resolution.height, 3, 3);
+
+  if (settings.headless.enabled) {
+    // Render into an offscreen framebuffer, no display required
+    if (!offscreen.initialize()) {
+      std::cerr << "Failed to create offscreen context" << std::endl;
+      return;
+    }
+  } else {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Create a windowed mode window and its OpenGL context
+    window = glfwCreateWindow(config.resolution.width,
+                              config.resolution.height, "benchmark driver",
+                              nullptr, nullptr);
+    if (!window) {
+      std::cerr << "Failed to create GLFW window" << std::endl;
+      return;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    // Initialize GLAD
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      std::cerr << "Failed to initialize GLAD" << std::endl;
+      glfwDestroyWindow(window);
+      return;
+    }
+  }
+
+  result.startup.context_ms = milliseconds_between(
+      context_start, std::chrono::steady_clock::now());
+
+  measure_configuration(config, scene, pool, settings, offscreen, window,
+                        result);
+
+  if (window != nullptr)
+    glfwDestroyWindow(window);
+}
+
+int main(int argc, char *argv[]) {
+  RunSettings settings;
+  DriverOptions options;
+  ProgramCacheOptions program_cache;
+  if (!parse_headless_options(argc, argv, settings.headless) ||
+      !parse_frame_timer_options(argc, argv, settings.timer_options) ||
+      !parse_program_cache_options(argc, argv, program_cache) ||
+      !parse_frame_capture_options(argc, argv, settings.capture_options) ||
+      !parse_driver_options(argc, argv, options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  if (options.list_strategies) {
+    for (const StrategyRegistration &registration : get_strategy_registry())
+      std::cout << registration.name << ": " << registration.description
+                << '\n';
+    return 0;
+  }
+
+  settings.field_of_view = options.field_of_view;
+  settings.simulation_rate = options.simulation_rate;
+  set_program_cache_directory(program_cache.directory);
+
+  std::vector<RunConfig> configs = expand_sweep(options.sweep);
+  bool sweeping = configs.size() > 1;
+  bool name_resolution = options.sweep.resolutions.size() > 1;
+  settings.fixed_frame_count = settings.headless.enabled || sweeping;
+  if (settings.fixed_frame_count)
+    clamp_warmup_frames(settings.timer_options, settings.headless.num_frames);
+  settings.write_frame_results =
+      !sweeping && !settings.timer_options.output_path.empty();
+
+  if (sweeping)
+    std::cout << "Sweeping " << configs.size() << " configurations\n";
+
+  if (!settings.headless.enabled && !glfwInit()) {
+    std::cerr << "Failed to initialize GLFW" << std::endl;
+    return -1;
+  }
+
+  // Scene generation and per frame animation are spread across every core,
+  // configurations are ordered by object count so consecutive runs share the
+  // scene
+  ThreadPool pool;
+  Scene scene;
+  std::vector<RunResult> results;
+  for (const RunConfig &config : configs) {
+    if (scene.num_objects != config.num_objects)
+      scene = generate_scene(config.num_objects, pool);
+
+    RunResult result;
+    result.config = config;
+    result.run_name = get_run_name(config, name_resolution);
+
+    std::cout << "Strategy: " << config.strategy_name
+              << ", number of objects: " << config.num_objects;
+    if (config.strategy_options.transform_encoding != TransformEncoding::mat4)
+      std::cout << ", encoding: "
+                << get_transform_encoding_name(
+                       config.strategy_options.transform_encoding);
+    if (config.strategy_options.vertex_layout != VertexLayout::aos_float)
+      std::cout << ", vertex layout: "
+                << get_vertex_layout_name(
+                       config.strategy_options.vertex_layout);
+    const ObjectMeshOptions &object_mesh = config.strategy_options.object_mesh;
+    if (object_mesh.shape != MeshShape::triangle)
+      std::cout << ", mesh: " << get_mesh_shape_name(object_mesh.shape)
+                << " with " << object_mesh.num_triangles
+                << " triangles, indices: "
+                << get_index_type_name(object_mesh.index_type);
+    if (name_resolution)
+      std::cout << ", resolution: " << config.resolution.width << "x"
+                << config.resolution.height;
+    if (config.strategy_options.dynamic_transforms)
+      std::cout << ", animated, upload: "
+                << get_upload_method_name(
+                       config.strategy_options.upload_method)
+                << ", threading: "
+                << (config.simulation_thread ? "simulation" : "single");
+    if (config.track_changes)
+      std::cout << ", moving: " << config.moving_percent << "%";
+    std::cout << '\n';
+
+    run_configuration(config, scene, pool, settings, result);
+    results.push_back(result);
+  }
+
+  if (!settings.headless.enabled)
+    glfwTerminate();
+
+  if (sweeping && !settings.timer_options.output_path.empty())
+    write_sweep_results(settings.timer_options.output_path, results,
+                        settings.timer_options.warmup_frames,
+                        settings.headless.num_frames);
+
+  // a failed configuration is part of a sweep's results, only a single run
+  // reports it through the exit code
+  return !sweeping && !results[0].succeeded ? 1 : 0;
+}
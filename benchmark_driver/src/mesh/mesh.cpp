@@ -0,0 +1,295 @@
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <glm/gtc/constants.hpp>
+#include <utility>
+
+static const std::array<std::pair<MeshShape, const char *>, 4>
+    mesh_shape_names = {{
+        {MeshShape::triangle, "triangle"},
+        {MeshShape::sphere, "sphere"},
+        {MeshShape::grid, "grid"},
+        {MeshShape::cube, "cube"},
+    }};
+
+bool parse_mesh_shape(const std::string &name, MeshShape &shape) {
+  for (const auto &[value, value_name] : mesh_shape_names) {
+    if (name == value_name) {
+      shape = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *get_mesh_shape_name(MeshShape shape) {
+  for (const auto &[value, value_name] : mesh_shape_names)
+    if (value == shape)
+      return value_name;
+  return "unknown";
+}
+
+bool is_closed_mesh_shape(MeshShape shape) {
+  return shape == MeshShape::sphere || shape == MeshShape::cube;
+}
+
+Mesh generate_sphere_mesh(int rings, int segments) {
+  Mesh mesh;
+  mesh.vertices.reserve(static_cast<size_t>(rings + 1) * (segments + 1));
+  for (int ring = 0; ring <= rings; ++ring) {
+    float theta = glm::pi<float>() * ring / rings;
+    for (int segment = 0; segment <= segments; ++segment) {
+      float phi = 2.0f * glm::pi<float>() * segment / segments;
+      glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta),
+                       std::sin(theta) * std::sin(phi));
+      MeshVertex vertex;
+      vertex.position = normal;
+      vertex.normal = normal;
+      vertex.uv = glm::vec2(static_cast<float>(segment) / segments,
+                            static_cast<float>(ring) / rings);
+      vertex.color = glm::vec4(0.5f + 0.5f * normal, 1.0f);
+      mesh.vertices.push_back(vertex);
+    }
+  }
+
+  // a is the quad's corner nearer the north pole at the lower segment, both
+  // triangles wind counter clockwise seen from outside
+  uint32_t row = segments + 1;
+  for (int ring = 0; ring < rings; ++ring) {
+    for (int segment = 0; segment < segments; ++segment) {
+      uint32_t a = ring * row + segment;
+      uint32_t b = a + row, c = b + 1, d = a + 1;
+      if (ring != 0)
+        mesh.indices.insert(mesh.indices.end(), {a, d, b});
+      if (ring != rings - 1)
+        mesh.indices.insert(mesh.indices.end(), {d, c, b});
+    }
+  }
+  return mesh;
+}
+
+// appends a rows x columns block of quads over the vertices from first on,
+// laid out row by row with columns + 1 per row, both triangles of a quad wind
+// counter clockwise seen from where u x v points
+static void append_quads(Mesh &mesh, uint32_t first, int rows, int columns) {
+  uint32_t row = columns + 1;
+  for (int v = 0; v < rows; ++v) {
+    for (int u = 0; u < columns; ++u) {
+      uint32_t a = first + v * row + u;
+      uint32_t b = a + 1, c = b + row, d = a + row;
+      mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+    }
+  }
+}
+
+Mesh generate_grid_mesh(int cells) {
+  Mesh mesh;
+  mesh.vertices.reserve(static_cast<size_t>(cells + 1) * (cells + 1));
+  float half_side = 1.0f / std::sqrt(2.0f);
+  for (int y = 0; y <= cells; ++y) {
+    for (int x = 0; x <= cells; ++x) {
+      glm::vec2 uv(static_cast<float>(x) / cells,
+                   static_cast<float>(y) / cells);
+      MeshVertex vertex;
+      vertex.position = glm::vec3(half_side * (2.0f * uv.x - 1.0f),
+                                  half_side * (2.0f * uv.y - 1.0f), 0.0f);
+      vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+      vertex.uv = uv;
+      vertex.color = glm::vec4(0.5f + 0.5f * vertex.position, 1.0f);
+      mesh.vertices.push_back(vertex);
+    }
+  }
+  append_quads(mesh, 0, cells, cells);
+  return mesh;
+}
+
+Mesh generate_cube_mesh(int subdivisions) {
+  // the outward normal and two axes along the face with u x v = normal
+  struct Face {
+    glm::vec3 normal, u, v;
+  };
+  static const Face faces[] = {
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+      {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+      {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+      {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+      {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+      {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+  };
+
+  Mesh mesh;
+  size_t face_vertices =
+      static_cast<size_t>(subdivisions + 1) * (subdivisions + 1);
+  mesh.vertices.reserve(std::size(faces) * face_vertices);
+  float half_side = 1.0f / std::sqrt(3.0f);
+  for (const Face &face : faces) {
+    uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+    for (int v = 0; v <= subdivisions; ++v) {
+      for (int u = 0; u <= subdivisions; ++u) {
+        glm::vec2 uv(static_cast<float>(u) / subdivisions,
+                     static_cast<float>(v) / subdivisions);
+        MeshVertex vertex;
+        vertex.position = half_side * (face.normal +
+                                       (2.0f * uv.x - 1.0f) * face.u +
+                                       (2.0f * uv.y - 1.0f) * face.v);
+        vertex.normal = face.normal;
+        vertex.uv = uv;
+        vertex.color = glm::vec4(0.5f + 0.5f * face.normal, 1.0f);
+        mesh.vertices.push_back(vertex);
+      }
+    }
+    append_quads(mesh, first, subdivisions, subdivisions);
+  }
+  return mesh;
+}
+
+// the tessellation of each shape closest to num_triangles, rings for a
+// sphere (with twice as many segments), cells along a side for a grid and
+// quads along an edge for a cube
+static int get_tessellation(MeshShape shape, int num_triangles) {
+  switch (shape) {
+  case MeshShape::triangle:
+    return 1;
+  case MeshShape::sphere:
+    return std::max<int>(
+        2, std::lround((1.0 + std::sqrt(1.0 + num_triangles)) / 2.0));
+  case MeshShape::grid:
+    return std::max<int>(1, std::lround(std::sqrt(num_triangles / 2.0)));
+  case MeshShape::cube:
+    return std::max<int>(1, std::lround(std::sqrt(num_triangles / 12.0)));
+  }
+  return 1;
+}
+
+int get_mesh_triangle_count(MeshShape shape, int num_triangles) {
+  int n = get_tessellation(shape, num_triangles);
+  switch (shape) {
+  case MeshShape::triangle:
+    return 1;
+  case MeshShape::sphere:
+    return 4 * n * (n - 1);
+  case MeshShape::grid:
+    return 2 * n * n;
+  case MeshShape::cube:
+    return 12 * n * n;
+  }
+  return 1;
+}
+
+Mesh generate_mesh(MeshShape shape, int num_triangles) {
+  int n = get_tessellation(shape, num_triangles);
+  switch (shape) {
+  case MeshShape::sphere:
+    return generate_sphere_mesh(n, 2 * n);
+  case MeshShape::grid:
+    return generate_grid_mesh(n);
+  case MeshShape::cube:
+    return generate_cube_mesh(n);
+  case MeshShape::triangle:
+    break;
+  }
+  return Mesh();
+}
+
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t num_vertices,
+                           int cache_size) {
+  size_t num_triangles = indices.size() / 3;
+
+  // the triangles using each vertex, as offsets into one flat list
+  std::vector<uint32_t> adjacency_offsets(num_vertices + 1, 0);
+  for (uint32_t index : indices)
+    ++adjacency_offsets[index + 1];
+  for (size_t v = 0; v < num_vertices; ++v)
+    adjacency_offsets[v + 1] += adjacency_offsets[v];
+  std::vector<uint32_t> adjacency(indices.size());
+  std::vector<uint32_t> fill(adjacency_offsets.begin(),
+                             adjacency_offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); ++i)
+    adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+  // live_triangles counts the triangles of a vertex not emitted yet,
+  // cache_time is the time stamp at which it last entered the cache
+  std::vector<int> live_triangles(num_vertices);
+  for (size_t v = 0; v < num_vertices; ++v)
+    live_triangles[v] = adjacency_offsets[v + 1] - adjacency_offsets[v];
+  std::vector<int> cache_time(num_vertices, 0);
+  std::vector<bool> emitted(num_triangles, false);
+  std::vector<uint32_t> dead_end_stack;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+
+  int time_stamp = cache_size + 1;
+  size_t cursor = 0;
+  // the vertex whose remaining triangles are emitted next, -1 once done
+  int64_t fanning_vertex = num_vertices > 0 ? 0 : -1;
+  while (fanning_vertex >= 0) {
+    candidates.clear();
+    uint32_t f = static_cast<uint32_t>(fanning_vertex);
+    for (uint32_t i = adjacency_offsets[f]; i < adjacency_offsets[f + 1];
+         ++i) {
+      uint32_t triangle = adjacency[i];
+      if (emitted[triangle])
+        continue;
+      for (int corner = 0; corner < 3; ++corner) {
+        uint32_t v = indices[triangle * 3 + corner];
+        output.push_back(v);
+        dead_end_stack.push_back(v);
+        candidates.push_back(v);
+        --live_triangles[v];
+        if (time_stamp - cache_time[v] > cache_size)
+          cache_time[v] = time_stamp++;
+      }
+      emitted[triangle] = true;
+    }
+
+    // the candidate that will still be in the cache after its remaining
+    // triangles are emitted and entered it longest ago
+    fanning_vertex = -1;
+    int best_priority = -1;
+    for (uint32_t v : candidates) {
+      if (live_triangles[v] <= 0)
+        continue;
+      int priority = 0;
+      if (time_stamp - cache_time[v] + 2 * live_triangles[v] <= cache_size)
+        priority = time_stamp - cache_time[v];
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning_vertex = v;
+      }
+    }
+
+    // dead end, fall back to a recently used vertex, then to input order
+    while (fanning_vertex < 0 && !dead_end_stack.empty()) {
+      uint32_t v = dead_end_stack.back();
+      dead_end_stack.pop_back();
+      if (live_triangles[v] > 0)
+        fanning_vertex = v;
+    }
+    while (fanning_vertex < 0 && cursor < num_vertices) {
+      if (live_triangles[cursor] > 0)
+        fanning_vertex = cursor;
+      ++cursor;
+    }
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+double compute_acmr(std::span<const uint32_t> indices, int cache_size) {
+  if (indices.size() < 3)
+    return 0.0;
+  std::deque<uint32_t> cache;
+  size_t misses = 0;
+  for (uint32_t index : indices) {
+    if (std::find(cache.begin(), cache.end(), index) != cache.end())
+      continue;
+    ++misses;
+    cache.push_back(index);
+    if (cache.size() > static_cast<size_t>(cache_size))
+      cache.pop_front();
+  }
+  return static_cast<double>(misses) / (indices.size() / 3);
+}
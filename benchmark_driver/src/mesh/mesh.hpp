@@ -0,0 +1,79 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+// the attributes a real asset carries, stored at full precision, vertex
+// layouts decide how they end up in gpu memory
+struct MeshVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 uv;
+  glm::vec4 color;
+};
+
+// an indexed triangle list whose positions lie within the unit sphere, so
+// that normalized integer formats can hold them unscaled
+struct Mesh {
+  std::vector<MeshVertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// what every object draws, the scene's triangle or a generated mesh of a
+// chosen size
+enum class MeshShape {
+  triangle,
+  // generate_sphere_mesh, closed and convex
+  sphere,
+  // generate_grid_mesh, a flat open square
+  grid,
+  // generate_cube_mesh, closed and convex
+  cube,
+};
+
+bool parse_mesh_shape(const std::string &name, MeshShape &shape);
+const char *get_mesh_shape_name(MeshShape shape);
+// whether every back face is hidden behind a front face, so that culling
+// them leaves the image unchanged
+bool is_closed_mesh_shape(MeshShape shape);
+
+// a uv sphere of radius 1 with rings + 1 rows of segments + 1 vertices (the
+// seam is duplicated for the uvs), triangles are emitted ring by ring, the
+// order an exporter that never reorders would leave them in, the pole rows
+// skip their degenerate triangles
+Mesh generate_sphere_mesh(int rings, int segments);
+
+// a square of cells x cells quads in the z = 0 plane facing +z, its corners
+// on the unit circle, emitted row by row
+Mesh generate_grid_mesh(int cells);
+
+// a cube whose faces are subdivisions x subdivisions quads each, its corners
+// on the unit sphere, the faces have vertices of their own so that each keeps
+// a flat normal, emitted face by face and row by row within a face
+Mesh generate_cube_mesh(int subdivisions);
+
+// the number of triangles the mesh of shape closest to num_triangles has,
+// each shape only comes in the counts its tessellation allows (4 r (r - 1)
+// for a sphere of r rings and 2 r segments, 2 n^2 for a grid and 12 n^2 for
+// a cube), always 1 for the triangle
+int get_mesh_triangle_count(MeshShape shape, int num_triangles);
+// the mesh get_mesh_triangle_count describes, not for the triangle, which
+// the scene already holds
+Mesh generate_mesh(MeshShape shape, int num_triangles);
+
+// reorders the triangles for the post transform vertex cache with tipsify
+// (Sander, Nehab, Barczak 2007) tuned for a cache of cache_size entries,
+// every triangle keeps its winding
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t num_vertices,
+                           int cache_size = 16);
+
+// average cache miss ratio, vertex shader invocations per triangle on a fifo
+// cache of cache_size entries, 3 without any reuse and about 0.5 at best for
+// a regular grid
+double compute_acmr(std::span<const uint32_t> indices, int cache_size = 32);
+
+#endif // MESH_HPP
@@ -0,0 +1,94 @@
+#include "object_mesh.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include "../scene/scene.hpp"
+
+bool create_object_mesh_vao(const ObjectMeshOptions &options, GLuint &vao,
+                            ObjectMesh &mesh) {
+  std::vector<glm::vec3> positions;
+  Mesh generated;
+  if (options.shape == MeshShape::triangle) {
+    for (int i = 0; i < 3; ++i)
+      positions.emplace_back(triangle_vertices[i * 3],
+                             triangle_vertices[i * 3 + 1],
+                             triangle_vertices[i * 3 + 2]);
+  } else {
+    generated = generate_mesh(options.shape, options.num_triangles);
+    if (!fits_index_type(generated.vertices.size(), options.index_type)) {
+      std::cerr << get_index_type_name(options.index_type)
+                << " indices cannot address the "
+                << generated.vertices.size() << " vertices of the "
+                << get_mesh_shape_name(options.shape) << std::endl;
+      return false;
+    }
+    positions.reserve(generated.vertices.size());
+    for (const MeshVertex &vertex : generated.vertices)
+      positions.push_back(vertex.position * triangle_bounding_radius);
+  }
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &mesh.vertex_buffer);
+  glBindVertexArray(vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, mesh.vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3),
+               positions.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+                        (GLvoid *)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  if (options.shape == MeshShape::triangle) {
+    mesh.count = static_cast<GLsizei>(positions.size());
+  } else {
+    GLsizeiptr index_size;
+    // the element array binding is vao state, left bound on purpose
+    mesh.index_buffer =
+        create_index_buffer(generated.indices, options.index_type, index_size);
+    mesh.count = static_cast<GLsizei>(generated.indices.size());
+    mesh.index_type = get_index_gl_type(options.index_type);
+    mesh.closed = is_closed_mesh_shape(options.shape);
+  }
+  glBindVertexArray(0);
+  return true;
+}
+
+void delete_object_mesh(ObjectMesh &mesh) {
+  glDeleteBuffers(1, &mesh.vertex_buffer);
+  glDeleteBuffers(1, &mesh.index_buffer);
+  mesh = ObjectMesh();
+}
+
+void draw_object_mesh_instanced(const ObjectMesh &mesh,
+                                GLsizei instance_count) {
+  if (mesh.index_type == GL_NONE) {
+    glDrawArraysInstanced(GL_TRIANGLES, 0, mesh.count, instance_count);
+    return;
+  }
+  // the back faces of a closed mesh are always hidden, like a real renderer
+  // the draw skips them instead of rasterizing them
+  if (mesh.closed)
+    glEnable(GL_CULL_FACE);
+  glDrawElementsInstanced(GL_TRIANGLES, mesh.count, mesh.index_type, nullptr,
+                          instance_count);
+  if (mesh.closed)
+    glDisable(GL_CULL_FACE);
+}
+
+DrawIndirectCommand get_indirect_command(const ObjectMesh &mesh) {
+  return {static_cast<GLuint>(mesh.count), 0, 0, 0, 0};
+}
+
+void draw_object_mesh_indirect(const ObjectMesh &mesh) {
+  if (mesh.index_type == GL_NONE) {
+    glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+    return;
+  }
+  if (mesh.closed)
+    glEnable(GL_CULL_FACE);
+  glDrawElementsIndirect(GL_TRIANGLES, mesh.index_type, nullptr);
+  if (mesh.closed)
+    glDisable(GL_CULL_FACE);
+}
@@ -0,0 +1,63 @@
+#ifndef OBJECT_MESH_HPP
+#define OBJECT_MESH_HPP
+
+#include <glad/glad.h>
+
+#include "../mesh/mesh.hpp"
+#include "../vertex_layout/vertex_layout.hpp"
+
+// what every object of a run draws
+struct ObjectMeshOptions {
+  MeshShape shape = MeshShape::triangle;
+  // the count get_mesh_triangle_count gives for the shape
+  int num_triangles = 1;
+  // meshes only, the triangle is drawn without indices
+  IndexType index_type = IndexType::u32;
+
+  bool operator==(const ObjectMeshOptions &) const = default;
+};
+
+// the geometry instanced strategies draw once per object, positions only as
+// 3 floats at attribute location 0 like the triangle, a mesh is scaled down
+// to triangle_bounding_radius so that the spacing of the objects and their
+// culling bounds stay the same
+struct ObjectMesh {
+  GLuint vertex_buffer = 0;
+  GLuint index_buffer = 0;
+  // indices, or vertices for the triangle
+  GLsizei count = 0;
+  // the type argument of glDrawElements*, GL_NONE for the triangle
+  GLenum index_type = GL_NONE;
+  // closed meshes are drawn with their back faces culled
+  bool closed = false;
+};
+
+// builds a vao holding the object mesh once with its index buffer bound,
+// returns false and logs the reason when the index type cannot address the
+// mesh's vertices
+bool create_object_mesh_vao(const ObjectMeshOptions &options, GLuint &vao,
+                            ObjectMesh &mesh);
+void delete_object_mesh(ObjectMesh &mesh);
+
+// glDrawArraysInstanced or glDrawElementsInstanced of the bound vao
+void draw_object_mesh_instanced(const ObjectMesh &mesh,
+                                GLsizei instance_count);
+
+// the layout glDrawElementsIndirect reads, glDrawArraysIndirect reads the
+// first four members as count, instance count, first and base instance, all
+// but the counts are 0 so one command serves both
+struct DrawIndirectCommand {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+// a command drawing the mesh, instance_count is left 0 for the caller
+DrawIndirectCommand get_indirect_command(const ObjectMesh &mesh);
+// draws the bound vao with the command at offset 0 of the bound
+// GL_DRAW_INDIRECT_BUFFER
+void draw_object_mesh_indirect(const ObjectMesh &mesh);
+
+#endif // OBJECT_MESH_HPP
@@ -0,0 +1,189 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+const GLfloat triangle_vertices[9] = {
+    0.0f,  0.1f,  0.0f, // Vertex 1
+    -0.1f, -0.1f, 0.0f, // Vertex 2
+    0.1f,  -0.1f, 0.0f  // Vertex 3
+};
+
+// distance from the origin to the two bottom vertices
+const float triangle_bounding_radius = 0.1f * std::sqrt(2.0f);
+
+static constexpr float object_scale = 0.3f;
+
+const char *scene_fragment_shader_source = R"(
+        #version 330 core
+        out vec4 FragColor;
+        void main() {
+            FragColor = vec4(0.0f, 1.0f, 0.0f, 1.0f); // Green color for the triangles
+        }
+    )";
+
+static int get_grid_size(int num_objects) {
+  int grid_size = static_cast<int>(ceil(pow(num_objects, 1.0f / 3.0f)));
+  return std::max(grid_size, 2);
+}
+
+void generate_model_matrices(glm::mat4 *model_matrices, int num_objects,
+                             glm::vec3 origin) {
+  // Calculate grid size for a perfect cube, at least 2 to prevent holes
+  int grid_size = get_grid_size(num_objects);
+
+  // Spacing for the grid
+  float spacing = 2.0f / (grid_size - 1);
+
+  // Generate matrices
+  for (int i = 0; i < num_objects; ++i) {
+    int layer = i / (grid_size * grid_size);             // z-axis
+    int row = (i % (grid_size * grid_size)) / grid_size; // y-axis
+    int col = i % grid_size;                             // x-axis
+
+    // Map the grid positions to NDC space
+    float x = origin.x + col * spacing;
+    float y = origin.y + row * spacing;
+    float z = origin.z + layer * spacing;
+
+    // Apply the transformation for the current model
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(x, y, z));
+    model = glm::scale(model, glm::vec3(object_scale)); // Scale the object
+
+    // Store the model matrix
+    model_matrices[i] = model;
+  }
+}
+
+// writes objects [first, last) of the grid, positions are produced batch_size
+// at a time with the grid coordinates stepped incrementally instead of
+// divided out per object, then every matrix is four straight column stores
+static void write_grid_matrices(glm::mat4 *model_matrices, int first,
+                                int last, int grid_size, float spacing,
+                                glm::vec3 origin) {
+  constexpr int batch_size = 64;
+  alignas(64) float xs[batch_size], ys[batch_size], zs[batch_size];
+
+  int layer = first / (grid_size * grid_size);
+  int row = (first % (grid_size * grid_size)) / grid_size;
+  int col = first % grid_size;
+
+  for (int batch_start = first; batch_start < last; batch_start += batch_size) {
+    int count = std::min(batch_size, last - batch_start);
+
+    for (int k = 0; k < count; ++k) {
+      xs[k] = origin.x + col * spacing;
+      ys[k] = origin.y + row * spacing;
+      zs[k] = origin.z + layer * spacing;
+      if (++col == grid_size) {
+        col = 0;
+        if (++row == grid_size) {
+          row = 0;
+          ++layer;
+        }
+      }
+    }
+
+    glm::mat4 *destination = model_matrices + batch_start;
+    for (int k = 0; k < count; ++k) {
+      destination[k][0] = glm::vec4(object_scale, 0.0f, 0.0f, 0.0f);
+      destination[k][1] = glm::vec4(0.0f, object_scale, 0.0f, 0.0f);
+      destination[k][2] = glm::vec4(0.0f, 0.0f, object_scale, 0.0f);
+      destination[k][3] = glm::vec4(xs[k], ys[k], zs[k], 1.0f);
+    }
+  }
+}
+
+void generate_model_matrices_parallel(ThreadPool &pool,
+                                      glm::mat4 *model_matrices,
+                                      int num_objects, glm::vec3 origin) {
+  int grid_size = get_grid_size(num_objects);
+  float spacing = 2.0f / (grid_size - 1);
+  pool.parallel_for(num_objects, [&](size_t first, size_t last) {
+    write_grid_matrices(model_matrices, first, last, grid_size, spacing,
+                        origin);
+  });
+}
+
+Scene generate_scene(int num_objects, ThreadPool &pool) {
+  Scene scene;
+  scene.num_objects = num_objects;
+  scene.arena =
+      std::make_unique<Arena>(Arena::footprint<glm::mat4>(num_objects));
+  scene.model_matrices = scene.arena->allocate<glm::mat4>(num_objects);
+
+  // Define a margin to space out the cubes
+  float margin = 0.5f;
+
+  // top-right, top-left, bottom-left, bottom-right
+  const glm::vec3 origins[4] = {
+      glm::vec3(1.0f + margin, 1.0f + margin, -1.0f),
+      glm::vec3(-1.0f - margin, 1.0f + margin, -1.0f),
+      glm::vec3(-1.0f - margin, -1.0f - margin, -1.0f),
+      glm::vec3(1.0f + margin, -1.0f - margin, -1.0f),
+  };
+
+  int first_object = 0;
+  for (int cube = 0; cube < 4; ++cube) {
+    int cube_objects = num_objects / 4 + (cube < num_objects % 4 ? 1 : 0);
+    if (cube_objects > 0)
+      generate_model_matrices_parallel(
+          pool, scene.model_matrices.data() + first_object, cube_objects,
+          origins[cube]);
+    first_object += cube_objects;
+  }
+  return scene;
+}
+
+static glm::mat4 animate_model_matrix(const Scene &scene, float time,
+                                      size_t i) {
+  glm::mat4 model = scene.model_matrices[i];
+  model[3][1] += 0.05f * sin(2.0f * time + 0.37f * i);
+  return model;
+}
+
+void animate_model_matrices(ThreadPool &pool, const Scene &scene, float time,
+                            glm::mat4 *model_matrices) {
+  pool.parallel_for(scene.num_objects, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i)
+      model_matrices[i] = animate_model_matrix(scene, time, i);
+  });
+}
+
+void animate_model_matrices(ThreadPool &pool, const Scene &scene, float time,
+                            std::span<const uint32_t> objects,
+                            glm::mat4 *model_matrices) {
+  pool.parallel_for(objects.size(), [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      uint32_t object = objects[i];
+      model_matrices[object] = animate_model_matrix(scene, time, object);
+    }
+  });
+}
+
+void create_expanded_triangle_vao(int num_objects, GLuint &vao, GLuint &vbo) {
+  GLsizeiptr size =
+      static_cast<GLsizeiptr>(num_objects) * sizeof(triangle_vertices);
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glBindVertexArray(vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+  GLfloat *vertices = static_cast<GLfloat *>(glMapBufferRange(
+      GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  for (int i = 0; i < num_objects; ++i)
+    std::copy(triangle_vertices, triangle_vertices + 9,
+              vertices + static_cast<size_t>(i) * 9);
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                        (GLvoid *)0);
+  glEnableVertexAttribArray(0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
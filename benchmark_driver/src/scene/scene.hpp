@@ -0,0 +1,74 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+
+#include "arena/arena.hpp"
+#include "thread_pool/thread_pool.hpp"
+
+// the scene every strategy renders: num_objects copies of one small triangle
+// laid out on grids forming four cubes around the origin, each object has its
+// own model matrix and objects are numbered in the order of model_matrices
+struct Scene {
+  int num_objects = 0;
+  // a single allocation sized from num_objects that every per object array
+  // below lives in
+  std::unique_ptr<Arena> arena;
+  std::span<glm::mat4> model_matrices;
+};
+
+// the per frame state shared by all strategies
+struct FrameUniforms {
+  glm::mat4 projection;
+  glm::mat4 view;
+};
+
+// fills model_matrices with num_objects translate + scale matrices on a grid
+// forming a cube whose corner is at origin, the serial reference
+// implementation
+void generate_model_matrices(glm::mat4 *model_matrices, int num_objects,
+                             glm::vec3 origin);
+
+// produces exactly the matrices generate_model_matrices does, split across
+// the pool, each range computes its grid positions a batch at a time into
+// structure of arrays form and writes the matrix columns straight into the
+// destination, which may be mapped gpu memory
+void generate_model_matrices_parallel(ThreadPool &pool,
+                                      glm::mat4 *model_matrices,
+                                      int num_objects, glm::vec3 origin);
+
+// splits num_objects across the four cubes, the first cubes take the
+// remainder when num_objects is not a multiple of four
+Scene generate_scene(int num_objects, ThreadPool &pool);
+
+// writes every object's matrix for the given time, objects bob up and down
+// around their place in the scene each with its own phase, used by runs with
+// dynamic transforms
+void animate_model_matrices(ThreadPool &pool, const Scene &scene, float time,
+                            glm::mat4 *model_matrices);
+
+// the same animation for the listed objects only, every other matrix is left
+// as it is
+void animate_model_matrices(ThreadPool &pool, const Scene &scene, float time,
+                            std::span<const uint32_t> objects,
+                            glm::mat4 *model_matrices);
+
+// the triangle every object draws, 3 vertices with 3 components
+extern const GLfloat triangle_vertices[9];
+// radius of the sphere around the object space origin that holds the
+// triangle, for culling
+extern const float triangle_bounding_radius;
+
+// builds a vao whose vbo holds one copy of the triangle per object so that
+// gl_VertexID / 3 is the object index, the attribute is at location 0, the
+// copies are written straight into the mapped buffer
+void create_expanded_triangle_vao(int num_objects, GLuint &vao, GLuint &vbo);
+
+// constant color fragment shader used by every strategy
+extern const char *scene_fragment_shader_source;
+
+#endif // SCENE_HPP
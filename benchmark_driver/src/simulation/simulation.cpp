@@ -0,0 +1,52 @@
+#include "simulation.hpp"
+
+SimulationThread::SimulationThread(const Scene &scene, ThreadPool &pool,
+                                   double tick_rate, bool fixed_time_step)
+    : scene(scene), pool(pool), tick_rate(tick_rate),
+      fixed_time_step(fixed_time_step) {
+  thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread() {
+  stopping = true;
+  thread.join();
+}
+
+void SimulationThread::run() {
+  using clock = std::chrono::steady_clock;
+  clock::time_point first_tick = clock::now();
+  for (uint64_t sequence = 1; !stopping; ++sequence) {
+    if (tick_rate > 0.0) {
+      std::this_thread::sleep_until(
+          first_tick + std::chrono::duration_cast<clock::duration>(
+                           std::chrono::duration<double>((sequence - 1) /
+                                                         tick_rate)));
+    }
+
+    TransformSnapshot &snapshot = snapshots.get_write_slot();
+    snapshot.simulation_start = clock::now();
+    snapshot.sequence = sequence;
+    snapshot.time =
+        fixed_time_step
+            ? (sequence - 1) / 60.0f
+            : std::chrono::duration<float>(snapshot.simulation_start -
+                                           first_tick)
+                  .count();
+    // slots are reused, only the first tick in each one allocates
+    snapshot.model_matrices.resize(scene.num_objects);
+    animate_model_matrices(pool, scene, snapshot.time,
+                           snapshot.model_matrices.data());
+    snapshot.simulation_end = clock::now();
+    snapshots.publish();
+  }
+}
+
+const TransformSnapshot &SimulationThread::acquire_latest(bool &fresh) {
+  fresh = snapshots.update();
+  while (!has_snapshot && !fresh) {
+    std::this_thread::yield();
+    fresh = snapshots.update();
+  }
+  has_snapshot = true;
+  return snapshots.get_read_slot();
+}
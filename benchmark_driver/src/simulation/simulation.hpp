@@ -0,0 +1,61 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+
+#include "triple_buffer/triple_buffer.hpp"
+#include "../scene/scene.hpp"
+
+// one tick of simulation output, everything the gl thread needs to draw it
+struct TransformSnapshot {
+  std::vector<glm::mat4> model_matrices;
+  // the animation time the matrices are for
+  float time = 0.0f;
+  // counts ticks from 1, gaps seen by the gl thread are ticks it never drew
+  uint64_t sequence = 0;
+  std::chrono::steady_clock::time_point simulation_start;
+  std::chrono::steady_clock::time_point simulation_end;
+};
+
+// animates the scene on a thread of its own, the way an engine runs its
+// simulation apart from the gl thread, and publishes every tick through a
+// triple buffer that the gl thread takes the latest tick from, neither side
+// ever blocks the other
+class SimulationThread {
+public:
+  // tick_rate 0 simulates back to back, otherwise ticks start 1 / tick_rate
+  // seconds apart, with fixed_time_step the animation time advances 1/60 s
+  // per tick so headless runs animate the same whatever the timing, the
+  // scene and the pool outlive the thread, the pool may be shared with the
+  // gl thread
+  SimulationThread(const Scene &scene, ThreadPool &pool, double tick_rate,
+                   bool fixed_time_step);
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread &) = delete;
+  SimulationThread &operator=(const SimulationThread &) = delete;
+
+  // gl thread only, the latest published tick, fresh tells whether it is
+  // new since the previous call, the first call waits for the first tick
+  const TransformSnapshot &acquire_latest(bool &fresh);
+
+private:
+  void run();
+
+  const Scene &scene;
+  ThreadPool &pool;
+  double tick_rate;
+  bool fixed_time_step;
+
+  TripleBuffer<TransformSnapshot> snapshots;
+  bool has_snapshot = false;
+  std::atomic<bool> stopping = false;
+  std::thread thread;
+};
+
+#endif // SIMULATION_HPP
@@ -0,0 +1,654 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+static std::vector<std::string> split(const std::string &value,
+                                      char separator) {
+  std::vector<std::string> parts;
+  std::stringstream stream(value);
+  std::string part;
+  while (std::getline(stream, part, separator))
+    parts.push_back(part);
+  return parts;
+}
+
+// the whole string must be a positive integer
+static bool parse_positive_int(const std::string &text, int &value) {
+  char *end = nullptr;
+  long parsed = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || parsed <= 0 ||
+      parsed > std::numeric_limits<int>::max())
+    return false;
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+// what is counted names the counts in the error messages
+static bool parse_counts(const std::string &value, const std::string &what,
+                         std::vector<int> &counts) {
+  std::vector<int> parsed;
+  if (value.find(':') != std::string::npos) {
+    std::vector<std::string> parts = split(value, ':');
+    int first, last;
+    double factor = 10.0;
+    if ((parts.size() != 2 && parts.size() != 3) ||
+        !parse_positive_int(parts[0], first) ||
+        !parse_positive_int(parts[1], last) || last < first ||
+        (parts.size() == 3 && !(std::atof(parts[2].c_str()) > 1.0))) {
+      std::cerr << "Error: " << what
+                << " range must be first:last[:factor] with "
+                   "first <= last and factor > 1, got "
+                << value << "\n";
+      return false;
+    }
+    if (parts.size() == 3)
+      factor = std::atof(parts[2].c_str());
+    // rounding can land two steps of a small factor on the same count
+    for (double count = first; count < last; count *= factor) {
+      int rounded = static_cast<int>(std::lround(count));
+      if (parsed.empty() || parsed.back() != rounded)
+        parsed.push_back(rounded);
+    }
+    if (parsed.empty() || parsed.back() != last)
+      parsed.push_back(last);
+  } else {
+    for (const std::string &part : split(value, ',')) {
+      int count;
+      if (!parse_positive_int(part, count)) {
+        std::cerr << "Error: " << what
+                  << " count must be a positive integer, got " << part
+                  << "\n";
+        return false;
+      }
+      parsed.push_back(count);
+    }
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no " << what << " counts given\n";
+    return false;
+  }
+  counts = parsed;
+  return true;
+}
+
+bool parse_object_counts(const std::string &value, std::vector<int> &counts) {
+  return parse_counts(value, "object", counts);
+}
+
+bool parse_strategy_names(const std::string &value,
+                          std::vector<std::string> &names) {
+  std::vector<std::string> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      for (const StrategyRegistration &registration : get_strategy_registry())
+        parsed.push_back(registration.name);
+      continue;
+    }
+    bool registered = false;
+    for (const StrategyRegistration &registration : get_strategy_registry())
+      registered = registered || registration.name == name;
+    if (!registered) {
+      std::cerr << "Error: unknown strategy " << name
+                << ", see --list-strategies\n";
+      return false;
+    }
+    parsed.push_back(name);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no strategies given\n";
+    return false;
+  }
+  names = parsed;
+  return true;
+}
+
+bool parse_resolutions(const std::string &value,
+                       std::vector<Resolution> &resolutions) {
+  std::vector<Resolution> parsed;
+  for (const std::string &part : split(value, ',')) {
+    std::vector<std::string> sides = split(part, 'x');
+    Resolution resolution;
+    if (sides.size() != 2 || !parse_positive_int(sides[0], resolution.width) ||
+        !parse_positive_int(sides[1], resolution.height)) {
+      std::cerr << "Error: resolution must be WIDTHxHEIGHT, got " << part
+                << "\n";
+      return false;
+    }
+    parsed.push_back(resolution);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no resolutions given\n";
+    return false;
+  }
+  resolutions = parsed;
+  return true;
+}
+
+bool parse_upload_methods(const std::string &value,
+                          std::vector<UploadMethod> &methods) {
+  static const UploadMethod all_methods[] = {
+      UploadMethod::buffer_data, UploadMethod::buffer_sub_data,
+      UploadMethod::map_invalidate, UploadMethod::map_unsynchronized,
+      UploadMethod::persistent_ring};
+
+  std::vector<UploadMethod> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), std::begin(all_methods),
+                    std::end(all_methods));
+      continue;
+    }
+    UploadMethod method;
+    if (!parse_upload_method(name, method)) {
+      std::cerr << "Error: unknown upload method: " << name
+                << ", expected buffer_data, buffer_sub_data, "
+                   "map_invalidate, map_unsynchronized, "
+                   "persistent_ring or all\n";
+      return false;
+    }
+    parsed.push_back(method);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no upload methods given\n";
+    return false;
+  }
+  methods = parsed;
+  return true;
+}
+
+bool parse_transform_encodings(const std::string &value,
+                               std::vector<TransformEncoding> &encodings) {
+  static const TransformEncoding all_encodings[] = {
+      TransformEncoding::mat4,
+      TransformEncoding::mat3x4,
+      TransformEncoding::quaternion,
+      TransformEncoding::position_scale,
+      TransformEncoding::quaternion_half,
+      TransformEncoding::position_scale_half};
+
+  std::vector<TransformEncoding> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), std::begin(all_encodings),
+                    std::end(all_encodings));
+      continue;
+    }
+    TransformEncoding encoding;
+    if (!parse_transform_encoding(name, encoding)) {
+      std::cerr << "Error: unknown transform encoding: " << name
+                << ", expected mat4, mat3x4, quat, pos_scale, quat_half, "
+                   "pos_scale_half or all\n";
+      return false;
+    }
+    parsed.push_back(encoding);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no transform encodings given\n";
+    return false;
+  }
+  encodings = parsed;
+  return true;
+}
+
+bool parse_vertex_layouts(const std::string &value,
+                          std::vector<VertexLayout> &layouts) {
+  static const VertexLayout all_layouts[] = {
+      VertexLayout::aos_float, VertexLayout::soa_float, VertexLayout::aos_half,
+      VertexLayout::aos_packed};
+
+  std::vector<VertexLayout> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), std::begin(all_layouts),
+                    std::end(all_layouts));
+      continue;
+    }
+    VertexLayout layout;
+    if (!parse_vertex_layout(name, layout)) {
+      std::cerr << "Error: unknown vertex layout: " << name
+                << ", expected aos_float, soa_float, aos_half, aos_packed or "
+                   "all\n";
+      return false;
+    }
+    parsed.push_back(layout);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no vertex layouts given\n";
+    return false;
+  }
+  layouts = parsed;
+  return true;
+}
+
+bool parse_mesh_shapes(const std::string &value,
+                       std::vector<MeshShape> &shapes) {
+  static const MeshShape all_shapes[] = {MeshShape::triangle,
+                                         MeshShape::sphere, MeshShape::grid,
+                                         MeshShape::cube};
+
+  std::vector<MeshShape> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), std::begin(all_shapes),
+                    std::end(all_shapes));
+      continue;
+    }
+    MeshShape shape;
+    if (!parse_mesh_shape(name, shape)) {
+      std::cerr << "Error: unknown mesh: " << name
+                << ", expected triangle, sphere, grid, cube or all\n";
+      return false;
+    }
+    parsed.push_back(shape);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no meshes given\n";
+    return false;
+  }
+  shapes = parsed;
+  return true;
+}
+
+bool parse_mesh_triangle_counts(const std::string &value,
+                                std::vector<int> &counts) {
+  return parse_counts(value, "triangle", counts);
+}
+
+bool parse_index_types(const std::string &value,
+                       std::vector<IndexType> &types) {
+  std::vector<IndexType> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), {IndexType::u16, IndexType::u32});
+      continue;
+    }
+    IndexType type;
+    if (!parse_index_type(name, type)) {
+      std::cerr << "Error: unknown index type: " << name
+                << ", expected u16, u32 or all\n";
+      return false;
+    }
+    parsed.push_back(type);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no index types given\n";
+    return false;
+  }
+  types = parsed;
+  return true;
+}
+
+bool parse_threading_modes(const std::string &value,
+                           std::vector<bool> &simulation_threads) {
+  std::vector<bool> parsed;
+  for (const std::string &name : split(value, ',')) {
+    if (name == "all") {
+      parsed.insert(parsed.end(), {false, true});
+    } else if (name == "single" || name == "simulation") {
+      parsed.push_back(name == "simulation");
+    } else {
+      std::cerr << "Error: unknown threading mode: " << name
+                << ", expected single, simulation or all\n";
+      return false;
+    }
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no threading modes given\n";
+    return false;
+  }
+  simulation_threads = parsed;
+  return true;
+}
+
+bool parse_moving_percents(const std::string &value,
+                           std::vector<double> &percents) {
+  std::vector<double> parsed;
+  for (const std::string &item : split(value, ',')) {
+    char *end = nullptr;
+    double percent = std::strtod(item.c_str(), &end);
+    if (item.empty() || *end != '\0' || percent < 0.0 || percent > 100.0) {
+      std::cerr << "Error: invalid moving percentage: " << item
+                << ", expected a number between 0 and 100\n";
+      return false;
+    }
+    parsed.push_back(percent);
+  }
+  if (parsed.empty()) {
+    std::cerr << "Error: no moving percentages given\n";
+    return false;
+  }
+  percents = parsed;
+  return true;
+}
+
+std::vector<RunConfig> expand_sweep(const SweepOptions &options) {
+  std::vector<UploadMethod> upload_methods = options.upload_methods;
+  std::vector<bool> simulation_threads = options.simulation_threads;
+  // -1 stands for every object moving without change tracking
+  std::vector<double> moving_percents = options.moving_percents;
+  if (moving_percents.empty())
+    moving_percents = {-1.0};
+  if (!options.dynamic_transforms) {
+    upload_methods.resize(1);
+    simulation_threads = {false};
+    moving_percents = {-1.0};
+  }
+
+  std::vector<ObjectMeshOptions> object_meshes;
+  for (MeshShape shape : options.mesh_shapes) {
+    std::vector<ObjectMeshOptions> shape_meshes;
+    if (shape == MeshShape::triangle) {
+      shape_meshes.push_back(ObjectMeshOptions());
+    } else {
+      for (int num_triangles : options.mesh_triangle_counts)
+        for (IndexType index_type : options.index_types)
+          shape_meshes.push_back(
+              {shape, get_mesh_triangle_count(shape, num_triangles),
+               index_type});
+    }
+    for (const ObjectMeshOptions &mesh : shape_meshes)
+      if (std::find(object_meshes.begin(), object_meshes.end(), mesh) ==
+          object_meshes.end())
+        object_meshes.push_back(mesh);
+  }
+
+  std::vector<RunConfig> configs;
+  for (int num_objects : options.object_counts)
+    for (const std::string &strategy_name : options.strategy_names)
+      for (TransformEncoding encoding : options.transform_encodings)
+        for (VertexLayout layout : options.vertex_layouts)
+          for (const ObjectMeshOptions &object_mesh : object_meshes)
+            for (UploadMethod upload_method : upload_methods)
+              for (bool simulation_thread : simulation_threads)
+                for (double moving_percent : moving_percents)
+                  for (const Resolution &resolution : options.resolutions) {
+                    RunConfig config;
+                    config.strategy_name = strategy_name;
+                    config.num_objects = num_objects;
+                    config.resolution = resolution;
+                    config.strategy_options.dynamic_transforms =
+                        options.dynamic_transforms;
+                    config.strategy_options.upload_method = upload_method;
+                    config.strategy_options.transform_encoding = encoding;
+                    config.strategy_options.vertex_layout = layout;
+                    config.strategy_options.object_mesh = object_mesh;
+                    config.simulation_thread = simulation_thread;
+                    config.track_changes = moving_percent >= 0.0;
+                    if (config.track_changes)
+                      config.moving_percent = moving_percent;
+                    configs.push_back(config);
+                  }
+  return configs;
+}
+
+// shortest form, 10 rather than 10.000000
+static std::string format_percent(double percent) {
+  std::ostringstream out;
+  out << percent;
+  return out.str();
+}
+
+std::string get_run_name(const RunConfig &config, bool include_resolution) {
+  std::string run_name =
+      config.strategy_name + "_" + std::to_string(config.num_objects);
+  TransformEncoding encoding = config.strategy_options.transform_encoding;
+  if (encoding != TransformEncoding::mat4)
+    run_name += std::string("_") + get_transform_encoding_name(encoding);
+  VertexLayout layout = config.strategy_options.vertex_layout;
+  if (layout != VertexLayout::aos_float)
+    run_name += std::string("_") + get_vertex_layout_name(layout);
+  const ObjectMeshOptions &object_mesh = config.strategy_options.object_mesh;
+  if (object_mesh.shape != MeshShape::triangle) {
+    run_name += std::string("_") + get_mesh_shape_name(object_mesh.shape) +
+                "_" + std::to_string(object_mesh.num_triangles);
+    if (object_mesh.index_type != IndexType::u32)
+      run_name +=
+          std::string("_") + get_index_type_name(object_mesh.index_type);
+  }
+  if (include_resolution)
+    run_name += "_" + std::to_string(config.resolution.width) + "x" +
+                std::to_string(config.resolution.height);
+  if (config.strategy_options.dynamic_transforms)
+    run_name += std::string("_animated_") +
+                get_upload_method_name(config.strategy_options.upload_method);
+  if (config.simulation_thread)
+    run_name += "_simulation_thread";
+  if (config.track_changes)
+    run_name += "_moving_" + format_percent(config.moving_percent);
+  return run_name;
+}
+
+// every metric any run recorded, in order of first appearance, so every row
+// of the table has the same columns
+static std::vector<std::string>
+get_metric_names(const std::vector<RunResult> &results) {
+  std::vector<std::string> names;
+  for (const RunResult &result : results)
+    for (const RunResult::Metric &metric : result.metrics)
+      if (std::find(names.begin(), names.end(), metric.name) == names.end())
+        names.push_back(metric.name);
+  return names;
+}
+
+static std::vector<std::string>
+get_run_value_names(const std::vector<RunResult> &results) {
+  std::vector<std::string> names;
+  for (const RunResult &result : results)
+    for (const FrameTimer::RunValue &run_value : result.run_values)
+      if (std::find(names.begin(), names.end(), run_value.name) == names.end())
+        names.push_back(run_value.name);
+  return names;
+}
+
+static const SampleSummary *find_metric(const RunResult &result,
+                                        const std::string &name) {
+  for (const RunResult::Metric &metric : result.metrics)
+    if (metric.name == name)
+      return &metric.summary;
+  return nullptr;
+}
+
+static bool write_json(std::ostream &out, const std::vector<RunResult> &results,
+                       int warmup_frames, int num_frames) {
+  // every run uses the same driver, take it from the first that got a context
+  std::string renderer = "unknown", version = "unknown";
+  for (const RunResult &result : results) {
+    if (!result.renderer.empty()) {
+      renderer = result.renderer;
+      version = result.version;
+      break;
+    }
+  }
+
+  out << "{\n";
+  out << "  \"renderer\": \"" << json_escape(renderer) << "\",\n";
+  out << "  \"version\": \"" << json_escape(version) << "\",\n";
+  out << "  \"warmup_frames\": " << warmup_frames << ",\n";
+  out << "  \"frames\": " << num_frames << ",\n";
+  out << "  \"runs\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const RunResult &result = results[i];
+    const RunConfig &config = result.config;
+    const ObjectMeshOptions &object_mesh = config.strategy_options.object_mesh;
+    out << (i == 0 ? "\n" : ",\n") << "    {\"run\": \""
+        << json_escape(result.run_name) << "\", \"strategy\": \""
+        << json_escape(config.strategy_name)
+        << "\", \"objects\": " << config.num_objects
+        << ", \"width\": " << config.resolution.width
+        << ", \"height\": " << config.resolution.height
+        << ", \"encoding\": \""
+        << get_transform_encoding_name(
+               config.strategy_options.transform_encoding)
+        << "\", \"vertex_layout\": \""
+        << get_vertex_layout_name(config.strategy_options.vertex_layout)
+        << "\", \"mesh\": \"" << get_mesh_shape_name(object_mesh.shape)
+        << "\", \"mesh_triangles\": " << object_mesh.num_triangles
+        << ", \"index_type\": ";
+    if (object_mesh.shape != MeshShape::triangle)
+      out << '"' << get_index_type_name(object_mesh.index_type) << '"';
+    else
+      out << "null";
+    out << ", \"animated\": "
+        << (config.strategy_options.dynamic_transforms ? "true" : "false")
+        << ", \"upload\": ";
+    if (config.strategy_options.dynamic_transforms)
+      out << '"'
+          << get_upload_method_name(config.strategy_options.upload_method)
+          << '"';
+    else
+      out << "null";
+    out << ", \"threading\": ";
+    if (config.strategy_options.dynamic_transforms)
+      out << (config.simulation_thread ? "\"simulation\"" : "\"single\"");
+    else
+      out << "null";
+    out << ", \"moving\": ";
+    if (config.track_changes)
+      out << format_percent(config.moving_percent);
+    else
+      out << "null";
+    out << ", \"status\": \"" << (result.succeeded ? "ok" : "failed") << '"';
+    if (result.succeeded) {
+      const StartupTimes &startup = result.startup;
+      out << ",\n     \"startup\": {\"context_ms\": " << startup.context_ms
+          << ", \"initialize_ms\": " << startup.initialize_ms
+          << ", \"compile_ms\": " << startup.compile_ms
+          << ", \"link_ms\": " << startup.link_ms
+          << ", \"cache_load_ms\": " << startup.cache_load_ms
+          << ", \"programs_compiled\": " << startup.programs_compiled
+          << ", \"programs_loaded\": " << startup.programs_loaded
+          << ", \"first_frame_ms\": " << startup.first_frame_ms << "}";
+      out << ",\n     \"cpu_ms\": ";
+      write_json_summary(out, result.cpu_ms);
+      out << ",\n     \"gpu_ms\": ";
+      if (result.has_gpu_timing)
+        write_json_summary(out, result.gpu_ms);
+      else
+        out << "null";
+      for (const RunResult::Metric &metric : result.metrics) {
+        out << ",\n     \"" << json_escape(metric.name) << "\": ";
+        write_json_summary(out, metric.summary);
+      }
+      for (const FrameTimer::RunValue &run_value : result.run_values)
+        out << ",\n     \"" << json_escape(run_value.name)
+            << "\": " << run_value.value;
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+static bool write_csv(std::ostream &out,
+                      const std::vector<RunResult> &results) {
+  std::vector<std::string> metric_names = get_metric_names(results);
+  metric_names.insert(metric_names.begin(), {"cpu_ms", "gpu_ms"});
+  std::vector<std::string> run_value_names = get_run_value_names(results);
+
+  static const char *statistics[] = {"count", "min", "mean", "p50",
+                                     "p95",   "p99", "max", "stddev"};
+  out << "run,strategy,objects,width,height,encoding,vertex_layout,mesh,"
+         "mesh_triangles,index_type,animated,upload,threading,moving,status,"
+         "context_ms,initialize_ms,compile_ms,link_ms,cache_load_ms,"
+         "programs_compiled,programs_loaded,first_frame_ms";
+  for (const std::string &name : metric_names)
+    for (const char *statistic : statistics)
+      out << ',' << name << '_' << statistic;
+  for (const std::string &name : run_value_names)
+    out << ',' << name;
+  out << '\n';
+
+  for (const RunResult &result : results) {
+    const RunConfig &config = result.config;
+    bool animated = config.strategy_options.dynamic_transforms;
+    const ObjectMeshOptions &object_mesh = config.strategy_options.object_mesh;
+    bool indexed = object_mesh.shape != MeshShape::triangle;
+    out << result.run_name << ',' << config.strategy_name << ','
+        << config.num_objects << ',' << config.resolution.width << ','
+        << config.resolution.height << ','
+        << get_transform_encoding_name(
+               config.strategy_options.transform_encoding)
+        << ','
+        << get_vertex_layout_name(config.strategy_options.vertex_layout)
+        << ',' << get_mesh_shape_name(object_mesh.shape) << ','
+        << object_mesh.num_triangles << ','
+        << (indexed ? get_index_type_name(object_mesh.index_type) : "")
+        << ',' << (animated ? 1 : 0) << ','
+        << (animated
+                ? get_upload_method_name(config.strategy_options.upload_method)
+                : "")
+        << ','
+        << (animated ? (config.simulation_thread ? "simulation" : "single")
+                     : "")
+        << ','
+        << (config.track_changes ? format_percent(config.moving_percent) : "")
+        << ',' << (result.succeeded ? "ok" : "failed");
+
+    const StartupTimes &startup = result.startup;
+    if (result.succeeded)
+      out << ',' << startup.context_ms << ',' << startup.initialize_ms << ','
+          << startup.compile_ms << ',' << startup.link_ms << ','
+          << startup.cache_load_ms << ',' << startup.programs_compiled << ','
+          << startup.programs_loaded << ',' << startup.first_frame_ms;
+    else
+      out << std::string(8, ',');
+
+    for (const std::string &name : metric_names) {
+      const SampleSummary *summary = nullptr;
+      if (result.succeeded) {
+        if (name == "cpu_ms")
+          summary = &result.cpu_ms;
+        else if (name == "gpu_ms")
+          summary = result.has_gpu_timing ? &result.gpu_ms : nullptr;
+        else
+          summary = find_metric(result, name);
+      }
+      // missing values are left empty, as in the per frame csv
+      if (summary == nullptr) {
+        out << std::string(std::size(statistics), ',');
+        continue;
+      }
+      out << ',' << summary->count << ',' << summary->min << ','
+          << summary->mean << ',' << summary->p50 << ',' << summary->p95
+          << ',' << summary->p99 << ',' << summary->max << ','
+          << summary->standard_deviation;
+    }
+    for (const std::string &name : run_value_names) {
+      out << ',';
+      auto it = std::find_if(
+          result.run_values.begin(), result.run_values.end(),
+          [&](const FrameTimer::RunValue &v) { return v.name == name; });
+      if (result.succeeded && it != result.run_values.end())
+        out << it->value;
+    }
+    out << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+bool write_sweep_results(const std::string &path,
+                         const std::vector<RunResult> &results,
+                         int warmup_frames, int num_frames) {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open " << path << " for writing" << std::endl;
+    return false;
+  }
+  file << std::setprecision(6);
+
+  bool is_csv =
+      path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+  bool written = is_csv ? write_csv(file, results)
+                        : write_json(file, results, warmup_frames, num_frames);
+  if (!written)
+    std::cerr << "Failed to write results to " << path << std::endl;
+  return written;
+}
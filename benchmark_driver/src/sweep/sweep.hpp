@@ -0,0 +1,149 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <string>
+#include <vector>
+
+#include "frame_timer/frame_timer.hpp"
+#include "../transform_strategy/transform_strategy.hpp"
+
+struct Resolution {
+  int width;
+  int height;
+};
+
+// every list holds the values one driver flag was given, a sweep runs the
+// cartesian product of them, a plain single run is a sweep of one
+struct SweepOptions {
+  std::vector<std::string> strategy_names = {"multi_ubo"};
+  std::vector<int> object_counts = {1000};
+  std::vector<Resolution> resolutions = {{1920, 1080}};
+  std::vector<UploadMethod> upload_methods = {UploadMethod::buffer_sub_data};
+  std::vector<TransformEncoding> transform_encodings = {
+      TransformEncoding::mat4};
+  std::vector<VertexLayout> vertex_layouts = {VertexLayout::aos_float};
+  // what every object draws, triangle counts and index types only multiply
+  // the runs of the mesh shapes, counts are rounded to what the shape
+  // tessellates to and runs that end up the same are dropped
+  std::vector<MeshShape> mesh_shapes = {MeshShape::triangle};
+  std::vector<int> mesh_triangle_counts = {1000};
+  std::vector<IndexType> index_types = {IndexType::u32};
+  // whether animated runs simulate on a thread of their own
+  std::vector<bool> simulation_threads = {false};
+  // percentages of the objects animated each frame, with change tracking so
+  // that only those are uploaded, empty regenerates and uploads everything
+  std::vector<double> moving_percents;
+  bool dynamic_transforms = false;
+};
+
+// parsers for the list flags, each returns false and logs the reason when the
+// value is malformed, the lists are replaced rather than appended to
+
+// "100,1000,5000" or a geometric range "first:last[:factor]" (factor defaults
+// to 10), e.g. 1:1000000 gives 1, 10, 100, ... 1000000, last is always
+// included
+bool parse_object_counts(const std::string &value, std::vector<int> &counts);
+// comma separated registry names, "all" expands to every registered strategy
+bool parse_strategy_names(const std::string &value,
+                          std::vector<std::string> &names);
+// comma separated WIDTHxHEIGHT pairs, e.g. 1280x720,1920x1080
+bool parse_resolutions(const std::string &value,
+                       std::vector<Resolution> &resolutions);
+// comma separated upload method names, "all" expands to every method
+bool parse_upload_methods(const std::string &value,
+                          std::vector<UploadMethod> &methods);
+// comma separated encoding names, "all" expands to every encoding
+bool parse_transform_encodings(const std::string &value,
+                               std::vector<TransformEncoding> &encodings);
+// comma separated vertex layout names, "all" expands to every layout
+bool parse_vertex_layouts(const std::string &value,
+                          std::vector<VertexLayout> &layouts);
+// comma separated shape names, "all" expands to every shape, the triangle
+// included
+bool parse_mesh_shapes(const std::string &value,
+                       std::vector<MeshShape> &shapes);
+// triangles per object, the same forms as parse_object_counts
+bool parse_mesh_triangle_counts(const std::string &value,
+                                std::vector<int> &counts);
+// comma separated u16 and u32, "all" expands to both
+bool parse_index_types(const std::string &value,
+                       std::vector<IndexType> &types);
+// comma separated "single" (generate on the gl thread) and "simulation" (a
+// simulation thread feeding it), "all" expands to both
+bool parse_threading_modes(const std::string &value,
+                           std::vector<bool> &simulation_threads);
+// comma separated percentages between 0 and 100
+bool parse_moving_percents(const std::string &value,
+                           std::vector<double> &percents);
+
+struct RunConfig {
+  std::string strategy_name;
+  int num_objects;
+  Resolution resolution;
+  StrategyOptions strategy_options;
+  // animated runs only, the matrices come from a SimulationThread instead of
+  // being generated on the gl thread at the start of each frame
+  bool simulation_thread = false;
+  // animated runs only, whether only moving_percent of the objects move and
+  // only their changes are uploaded
+  bool track_changes = false;
+  double moving_percent = 100.0;
+};
+
+// ordered object count first so consecutive runs can share a scene, upload
+// methods and threading modes only multiply the runs when transforms are
+// animated
+std::vector<RunConfig> expand_sweep(const SweepOptions &options);
+
+// <strategy>_<objects>[_<encoding>][_<layout>][_<shape>_<triangles>[_u16]]
+// [_<width>x<height>][_animated_<upload>[_simulation_thread]
+// [_moving_<percent>]], the encoding is left out for mat4, the layout for
+// aos_float, the shape for the triangle, the index type for u32 and the
+// resolution is only part of the name when the sweep has more than one
+std::string get_run_name(const RunConfig &config, bool include_resolution);
+
+// one off costs of getting a run to its first frame, measured on the cpu
+struct StartupTimes {
+  double context_ms = 0.0;
+  // the strategy's initialize, building its programs included
+  double initialize_ms = 0.0;
+  // the program build part of initialize (shader_utils.hpp)
+  double compile_ms = 0.0;
+  double link_ms = 0.0;
+  double cache_load_ms = 0.0;
+  int programs_compiled = 0;
+  int programs_loaded = 0;
+  // drivers that compile lazily finish the job during the first draw
+  double first_frame_ms = 0.0;
+};
+
+struct RunResult {
+  RunConfig config;
+  std::string run_name;
+  // false when the strategy could not be set up for the configuration (the
+  // scene does not fit it or the context lacks a feature), the row is still
+  // written so that the table shows where a strategy stops working
+  bool succeeded = false;
+  std::string renderer;
+  std::string version;
+  StartupTimes startup;
+  SampleSummary cpu_ms;
+  bool has_gpu_timing = false;
+  SampleSummary gpu_ms;
+  struct Metric {
+    std::string name;
+    SampleSummary summary;
+  };
+  std::vector<Metric> metrics;
+  // values reported once for the run, written as a single column each
+  std::vector<FrameTimer::RunValue> run_values;
+};
+
+// one row per run with the summary of every timing, the extension picks the
+// format (.json or .csv) like FrameTimer::write_results, returns false if the
+// file could not be written
+bool write_sweep_results(const std::string &path,
+                         const std::vector<RunResult> &results,
+                         int warmup_frames, int num_frames);
+
+#endif // SWEEP_HPP
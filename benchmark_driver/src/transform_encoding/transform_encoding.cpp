@@ -0,0 +1,271 @@
+#include "transform_encoding.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/gtc/quaternion.hpp>
+#include <utility>
+
+static const std::array<std::pair<TransformEncoding, const char *>, 6>
+    transform_encoding_names = {{
+        {TransformEncoding::mat4, "mat4"},
+        {TransformEncoding::mat3x4, "mat3x4"},
+        {TransformEncoding::quaternion, "quat"},
+        {TransformEncoding::position_scale, "pos_scale"},
+        {TransformEncoding::quaternion_half, "quat_half"},
+        {TransformEncoding::position_scale_half, "pos_scale_half"},
+    }};
+
+bool parse_transform_encoding(const std::string &name,
+                              TransformEncoding &encoding) {
+  for (const auto &[value, value_name] : transform_encoding_names) {
+    if (name == value_name) {
+      encoding = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *get_transform_encoding_name(TransformEncoding encoding) {
+  for (const auto &[value, value_name] : transform_encoding_names)
+    if (value == encoding)
+      return value_name;
+  return "unknown";
+}
+
+GLsizeiptr get_encoded_transform_size(TransformEncoding encoding) {
+  switch (encoding) {
+  case TransformEncoding::mat4:
+    return 64;
+  case TransformEncoding::mat3x4:
+    return 48;
+  case TransformEncoding::quaternion:
+    return 32;
+  case TransformEncoding::position_scale:
+  case TransformEncoding::quaternion_half:
+    return 16;
+  case TransformEncoding::position_scale_half:
+    return 8;
+  }
+  return 64;
+}
+
+GLsizeiptr get_encoded_buffer_size(TransformEncoding encoding,
+                                   int num_objects) {
+  GLsizeiptr size = num_objects * get_encoded_transform_size(encoding);
+  return (size + 15) / 16 * 16;
+}
+
+bool is_half_precision(TransformEncoding encoding) {
+  return encoding == TransformEncoding::quaternion_half ||
+         encoding == TransformEncoding::position_scale_half;
+}
+
+// the matrices are translate * rotate * uniform scale, the scale is the length
+// of the first column
+struct Decomposed {
+  glm::vec3 position;
+  float scale;
+  glm::quat rotation;
+};
+
+static Decomposed decompose(const glm::mat4 &model) {
+  Decomposed decomposed;
+  decomposed.position = glm::vec3(model[3]);
+  decomposed.scale = glm::length(glm::vec3(model[0]));
+  float inverse_scale = 1.0f / decomposed.scale;
+  glm::mat3 rotation(glm::vec3(model[0]) * inverse_scale,
+                     glm::vec3(model[1]) * inverse_scale,
+                     glm::vec3(model[2]) * inverse_scale);
+  decomposed.rotation = glm::quat_cast(rotation);
+  return decomposed;
+}
+
+// encode(matrix) returns the object's bytes as a trivially copyable value
+template <typename Encode>
+static void encode_each(ThreadPool &pool,
+                        std::span<const glm::mat4> model_matrices,
+                        void *destination, Encode encode) {
+  std::byte *bytes = static_cast<std::byte *>(destination);
+  pool.parallel_for(model_matrices.size(), [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      auto encoded = encode(model_matrices[i]);
+      std::memcpy(bytes + i * sizeof(encoded), &encoded, sizeof(encoded));
+    }
+  });
+}
+
+void encode_transforms(ThreadPool &pool, TransformEncoding encoding,
+                       std::span<const glm::mat4> model_matrices,
+                       void *destination) {
+  switch (encoding) {
+  case TransformEncoding::mat4:
+    encode_each(pool, model_matrices, destination,
+                [](const glm::mat4 &model) { return model; });
+    break;
+  case TransformEncoding::mat3x4:
+    encode_each(pool, model_matrices, destination, [](const glm::mat4 &model) {
+      return std::array<glm::vec4, 3>{
+          glm::vec4(model[0][0], model[1][0], model[2][0], model[3][0]),
+          glm::vec4(model[0][1], model[1][1], model[2][1], model[3][1]),
+          glm::vec4(model[0][2], model[1][2], model[2][2], model[3][2])};
+    });
+    break;
+  case TransformEncoding::quaternion:
+    encode_each(pool, model_matrices, destination, [](const glm::mat4 &model) {
+      Decomposed d = decompose(model);
+      return std::array<glm::vec4, 2>{
+          glm::vec4(d.rotation.x, d.rotation.y, d.rotation.z, d.rotation.w),
+          glm::vec4(d.position, d.scale)};
+    });
+    break;
+  case TransformEncoding::position_scale:
+    encode_each(pool, model_matrices, destination, [](const glm::mat4 &model) {
+      return glm::vec4(glm::vec3(model[3]), glm::length(glm::vec3(model[0])));
+    });
+    break;
+  case TransformEncoding::quaternion_half:
+    encode_each(pool, model_matrices, destination, [](const glm::mat4 &model) {
+      Decomposed d = decompose(model);
+      return std::array<uint32_t, 4>{
+          glm::packHalf2x16(glm::vec2(d.rotation.x, d.rotation.y)),
+          glm::packHalf2x16(glm::vec2(d.rotation.z, d.rotation.w)),
+          glm::packHalf2x16(glm::vec2(d.position.x, d.position.y)),
+          glm::packHalf2x16(glm::vec2(d.position.z, d.scale))};
+    });
+    break;
+  case TransformEncoding::position_scale_half:
+    encode_each(pool, model_matrices, destination, [](const glm::mat4 &model) {
+      return std::array<uint32_t, 2>{
+          glm::packHalf2x16(glm::vec2(model[3][0], model[3][1])),
+          glm::packHalf2x16(
+              glm::vec2(model[3][2], glm::length(glm::vec3(model[0]))))};
+    });
+    break;
+  }
+}
+
+// every encoding's decode and fetch, one of them is compiled in, the half
+// precision encodings come last, rotating by a unit quaternion is
+// v + 2 q.xyz x (q.xyz x v + q.w v), two cross products instead of a matrix,
+// glsl 3.30 has no line continuations so each macro stays on one line
+const char *const transform_decode_glsl = R"(
+        #define ENCODING_MAT4 0
+        #define ENCODING_MAT3X4 1
+        #define ENCODING_QUATERNION 2
+        #define ENCODING_POSITION_SCALE 3
+        #define ENCODING_QUATERNION_HALF 4
+        #define ENCODING_POSITION_SCALE_HALF 5
+
+        #if ENCODING >= ENCODING_QUATERNION_HALF && __VERSION__ < 420
+        #extension GL_ARB_shading_language_packing : require
+        #endif
+
+        vec3 rotateByQuaternion(vec4 q, vec3 v) {
+            return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+        }
+
+        #if ENCODING == ENCODING_MAT4
+        const int transformVec4s = 4;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            mat4 model = mat4(uintBitsToFloat(transform[0]),
+                              uintBitsToFloat(transform[1]),
+                              uintBitsToFloat(transform[2]),
+                              uintBitsToFloat(transform[3]));
+            return (model * vec4(position, 1.0)).xyz;
+        }
+        #elif ENCODING == ENCODING_MAT3X4
+        const int transformVec4s = 3;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            vec4 p = vec4(position, 1.0);
+            return vec3(dot(uintBitsToFloat(transform[0]), p),
+                        dot(uintBitsToFloat(transform[1]), p),
+                        dot(uintBitsToFloat(transform[2]), p));
+        }
+        #elif ENCODING == ENCODING_QUATERNION
+        const int transformVec4s = 2;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            vec4 positionScale = uintBitsToFloat(transform[1]);
+            return rotateByQuaternion(uintBitsToFloat(transform[0]),
+                                      position * positionScale.w) +
+                   positionScale.xyz;
+        }
+        #elif ENCODING == ENCODING_POSITION_SCALE
+        const int transformVec4s = 1;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            vec4 positionScale = uintBitsToFloat(transform[0]);
+            return position * positionScale.w + positionScale.xyz;
+        }
+        #elif ENCODING == ENCODING_QUATERNION_HALF
+        const int transformVec4s = 1;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            // rounding leaves the quaternion slightly off unit length
+            vec4 rotation = normalize(vec4(unpackHalf2x16(transform[0].x),
+                                           unpackHalf2x16(transform[0].y)));
+            vec4 positionScale = vec4(unpackHalf2x16(transform[0].z),
+                                      unpackHalf2x16(transform[0].w));
+            return rotateByQuaternion(rotation, position * positionScale.w) +
+                   positionScale.xyz;
+        }
+        #elif ENCODING == ENCODING_POSITION_SCALE_HALF
+        const int transformVec4s = 1;
+        vec3 applyTransform(uvec4 transform[transformVec4s], vec3 position) {
+            vec4 positionScale = vec4(unpackHalf2x16(transform[0].x),
+                                      unpackHalf2x16(transform[0].y));
+            return position * positionScale.w + positionScale.xyz;
+        }
+        #endif
+
+        #if ENCODING == ENCODING_POSITION_SCALE_HALF
+        // two objects share a uvec4, the odd one is moved into .xy
+        uvec4 selectHalf(uvec4 pair, int index) {
+            return (index & 1) != 0 ? pair.zwzw : pair;
+        }
+        #define TRANSFORM_DATA_VEC4S(objects) ((objects) / 2)
+        #define FETCH_TRANSFORM(d, k) transform[0] = selectHalf(d[(k) / 2], k);
+        #else
+        #define TRANSFORM_DATA_VEC4S(objects) ((objects) * transformVec4s)
+        #define VEC4_OF(d, k, i) d[(k) * transformVec4s + (i)]
+        #define EACH_VEC4 for (int i = 0; i < transformVec4s; ++i)
+        #define FETCH_TRANSFORM(d, k) EACH_VEC4 transform[i] = VEC4_OF(d, k, i);
+        #endif
+    )";
+
+void set_transform_encoding_define(ShaderDefines &defines,
+                                   TransformEncoding encoding) {
+  const char *symbol = "ENCODING_MAT4";
+  switch (encoding) {
+  case TransformEncoding::mat4:
+    symbol = "ENCODING_MAT4";
+    break;
+  case TransformEncoding::mat3x4:
+    symbol = "ENCODING_MAT3X4";
+    break;
+  case TransformEncoding::quaternion:
+    symbol = "ENCODING_QUATERNION";
+    break;
+  case TransformEncoding::position_scale:
+    symbol = "ENCODING_POSITION_SCALE";
+    break;
+  case TransformEncoding::quaternion_half:
+    symbol = "ENCODING_QUATERNION_HALF";
+    break;
+  case TransformEncoding::position_scale_half:
+    symbol = "ENCODING_POSITION_SCALE_HALF";
+    break;
+  }
+  defines.set_symbol("ENCODING", symbol);
+}
+
+std::string get_transform_decode_glsl(TransformEncoding encoding) {
+  ShaderDefines defines;
+  set_transform_encoding_define(defines, encoding);
+  return defines.to_glsl() + transform_decode_glsl + "\n";
+}
+
+std::string get_transform_fetch_glsl(const std::string &array,
+                                     const std::string &index) {
+  return "FETCH_TRANSFORM(" + array + ", " + index + ")\n";
+}
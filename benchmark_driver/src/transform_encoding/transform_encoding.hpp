@@ -0,0 +1,75 @@
+#ifndef TRANSFORM_ENCODING_HPP
+#define TRANSFORM_ENCODING_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <span>
+#include <string>
+
+#include "shader_variants/shader_variants.hpp"
+#include "thread_pool/thread_pool.hpp"
+
+// how an object's transform is laid out in gpu memory, the scene only holds
+// translate + uniform scale matrices so every encoding reproduces them, the
+// half precision ones up to fp16 rounding (about 1e-3 at the scene's extent)
+enum class TransformEncoding {
+  // the full matrix, 64 bytes
+  mat4,
+  // the top three rows of the affine matrix, 48 bytes
+  mat3x4,
+  // rotation quaternion, then position and uniform scale, 32 bytes
+  quaternion,
+  // position and uniform scale, no rotation, 16 bytes
+  position_scale,
+  // quaternion, position and scale as 8 halves, 16 bytes
+  quaternion_half,
+  // position and scale as 4 halves, 8 bytes
+  position_scale_half,
+};
+
+bool parse_transform_encoding(const std::string &name,
+                              TransformEncoding &encoding);
+const char *get_transform_encoding_name(TransformEncoding encoding);
+
+// bytes one object takes up
+GLsizeiptr get_encoded_transform_size(TransformEncoding encoding);
+
+// bytes num_objects take up, rounded up to whole vec4s since shaders read the
+// data as uvec4 arrays
+GLsizeiptr get_encoded_buffer_size(TransformEncoding encoding,
+                                   int num_objects);
+
+// whether decoding needs unpackHalf2x16, glsl 4.20
+bool is_half_precision(TransformEncoding encoding);
+
+// writes the encoding of every matrix to destination, which may be mapped gpu
+// memory, split across the pool
+void encode_transforms(ThreadPool &pool, TransformEncoding encoding,
+                       std::span<const glm::mat4> model_matrices,
+                       void *destination);
+
+// glsl for shader templates, selects the encoding with ENCODING (see
+// set_transform_encoding_define) and declares transformVec4s, the number of
+// uvec4s an object's data is loaded into, vec3 applyTransform(uvec4
+// transform[transformVec4s], vec3 position) returning the position in world
+// space, TRANSFORM_DATA_VEC4S(objects), the uvec4s that many objects take
+// up, and the statement FETCH_TRANSFORM(data, index) loading object index's
+// data from the uvec4 array data into uvec4 transform[transformVec4s], it
+// enables ARB_shading_language_packing itself for half precision encodings
+// before glsl 4.20 and so must come before any declaration
+extern const char *const transform_decode_glsl;
+
+// ENCODING, as one of the ENCODING_<NAME> values transform_decode_glsl
+// defines
+void set_transform_encoding_define(ShaderDefines &defines,
+                                   TransformEncoding encoding);
+
+// transform_decode_glsl with ENCODING defined, for shaders assembled as
+// strings, placed after the declarations is fine from glsl 4.20 on
+std::string get_transform_decode_glsl(TransformEncoding encoding);
+
+// the FETCH_TRANSFORM statement for array and index
+std::string get_transform_fetch_glsl(const std::string &array,
+                                     const std::string &index);
+
+#endif // TRANSFORM_ENCODING_HPP
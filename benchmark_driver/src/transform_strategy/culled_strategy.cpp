@@ -0,0 +1,428 @@
+#include "culled_strategy.hpp"
+
+#include <cstddef>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+
+#include "../culling/frustum.hpp"
+#include "shader_utils/shader_utils.hpp"
+
+static const char *cull_compute_shader_source = R"(
+        #version 430 core
+        layout (local_size_x = 256) in;
+        layout (std430, binding = 0) readonly buffer ModelMatrices {
+            mat4 modelMatrices[];
+        };
+        layout (std430, binding = 1) writeonly buffer VisibleObjects {
+            uint visibleObjects[];
+        };
+        layout (binding = 0, offset = 0) uniform atomic_uint visibleCount;
+        uniform vec4 frustumPlanes[6];
+        uniform uint numObjects;
+        uniform float boundingRadius;
+
+        void main() {
+            uint index = gl_GlobalInvocationID.x;
+            if (index >= numObjects)
+                return;
+
+            mat4 model = modelMatrices[index];
+            vec3 center = model[3].xyz;
+            float scale = max(length(model[0].xyz),
+                              max(length(model[1].xyz), length(model[2].xyz)));
+            float radius = boundingRadius * scale;
+            for (int i = 0; i < 6; ++i)
+                if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w <
+                    -radius)
+                    return;
+
+            visibleObjects[atomicCounterIncrement(visibleCount)] = index;
+        }
+    )";
+
+static const char *gpu_culled_vertex_shader_source = R"(
+        #version 430 core
+        layout (location = 0) in vec3 position;
+        uniform mat4 projection;
+        uniform mat4 view;
+        layout (std430, binding = 0) readonly buffer ModelMatrices {
+            mat4 modelMatrices[];
+        };
+        layout (std430, binding = 1) readonly buffer VisibleObjects {
+            uint visibleObjects[];
+        };
+
+        void main() {
+            mat4 model = modelMatrices[visibleObjects[gl_InstanceID]];
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+// the cpu uploads the visible matrices already compacted
+static const char *cpu_culled_vertex_shader_source = R"(
+        #version 430 core
+        layout (location = 0) in vec3 position;
+        uniform mat4 projection;
+        uniform mat4 view;
+        layout (std430, binding = 0) readonly buffer ModelMatrices {
+            mat4 modelMatrices[];
+        };
+
+        void main() {
+            gl_Position = projection * view * modelMatrices[gl_InstanceID] *
+                          vec4(position, 1.0);
+        }
+    )";
+
+CulledStrategy::CulledStrategy(CullingMode mode) : mode(mode) {}
+
+CulledStrategy::~CulledStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  delete_object_mesh(object_mesh);
+  glDeleteBuffers(1, &ssbo);
+  glDeleteBuffers(1, &visible_objects_ssbo);
+  glDeleteBuffers(1, &indirect_buffer);
+  glDeleteBuffers(count_readback_buffers.size(),
+                  count_readback_buffers.data());
+  glDeleteProgram(shader_program);
+  glDeleteProgram(cull_program);
+}
+
+bool CulledStrategy::initialize(const Scene &scene,
+                                const StrategyOptions &options) {
+  if (!GLAD_GL_VERSION_4_3) {
+    std::cerr << "culled: compute shaders and shader storage buffers need "
+                 "OpenGL 4.3"
+              << std::endl;
+    return false;
+  }
+
+  num_objects = scene.num_objects;
+  GLint64 buffer_size = static_cast<GLint64>(num_objects) * sizeof(glm::mat4);
+
+  GLint64 max_block_size;
+  glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+  if (buffer_size > max_block_size) {
+    std::cerr << "culled: " << buffer_size
+              << " bytes of matrices exceed GL_MAX_SHADER_STORAGE_BLOCK_SIZE ("
+              << max_block_size << " bytes)" << std::endl;
+    return false;
+  }
+
+  if (!create_object_mesh_vao(options.object_mesh, vao, object_mesh))
+    return false;
+
+  bool initialized = mode == CullingMode::gpu
+                         ? initialize_gpu_culling(scene, options)
+                         : initialize_cpu_culling(scene, options);
+  if (!initialized)
+    return false;
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  return true;
+}
+
+bool CulledStrategy::initialize_gpu_culling(const Scene &scene,
+                                            const StrategyOptions &options) {
+  GLint max_work_groups;
+  glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &max_work_groups);
+  GLint64 num_work_groups =
+      (static_cast<GLint64>(num_objects) + work_group_size - 1) /
+      work_group_size;
+  if (num_work_groups > max_work_groups) {
+    std::cerr << "gpu_culled: " << num_objects
+              << " objects need more than GL_MAX_COMPUTE_WORK_GROUP_COUNT ("
+              << max_work_groups << ") work groups" << std::endl;
+    return false;
+  }
+
+  shader_program = create_shader_program(gpu_culled_vertex_shader_source,
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  cull_program = create_compute_program(cull_compute_shader_source);
+  if (cull_program == 0)
+    return false;
+  frustum_planes_location =
+      glGetUniformLocation(cull_program, "frustumPlanes");
+  num_objects_location = glGetUniformLocation(cull_program, "numObjects");
+  bounding_radius_location =
+      glGetUniformLocation(cull_program, "boundingRadius");
+
+  GLsizeiptr buffer_size =
+      static_cast<GLsizeiptr>(num_objects) * sizeof(glm::mat4);
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_SHADER_STORAGE_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(buffer_size, scene.model_matrices.data()))
+      return false;
+  } else {
+    glGenBuffers(1, &ssbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_size,
+                 scene.model_matrices.data(), GL_STATIC_DRAW);
+  }
+
+  // only ever written and read by the gpu
+  glGenBuffers(1, &visible_objects_ssbo);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible_objects_ssbo);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               static_cast<GLsizeiptr>(num_objects) * sizeof(GLuint), nullptr,
+               GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  // the instance count doubles as the atomic counter the culling pass
+  // increments
+  DrawIndirectCommand command = get_indirect_command(object_mesh);
+  glGenBuffers(1, &indirect_buffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), &command,
+               GL_DYNAMIC_COPY);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  glGenBuffers(count_readback_buffers.size(), count_readback_buffers.data());
+  for (GLuint readback_buffer : count_readback_buffers) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readback_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), nullptr,
+                 GL_STREAM_READ);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  cull_timer = std::make_unique<PassTimer>();
+  return true;
+}
+
+bool CulledStrategy::initialize_cpu_culling(const Scene &scene,
+                                            const StrategyOptions &options) {
+  shader_program = create_shader_program(cpu_culled_vertex_shader_source,
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  model_matrices = scene.model_matrices.data();
+  if (options.dynamic_transforms) {
+    dynamic_model_matrices.assign(scene.model_matrices.begin(),
+                                  scene.model_matrices.end());
+    model_matrices = dynamic_model_matrices.data();
+  }
+
+  if (mode != CullingMode::cpu) {
+    thread_pool = options.thread_pool;
+    if (thread_pool == nullptr) {
+      std::cerr << "culled: indexed culling needs the driver's thread pool"
+                << std::endl;
+      return false;
+    }
+    auto build_start = std::chrono::steady_clock::now();
+    spatial_index = create_spatial_index(mode == CullingMode::cpu_grid
+                                             ? SpatialIndexType::uniform_grid
+                                             : SpatialIndexType::bvh);
+    spatial_index->build(*thread_pool, scene.model_matrices,
+                         triangle_bounding_radius);
+    index_build_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - build_start)
+                         .count();
+  }
+
+  // visible matrices are uploaded every frame whether or not the scene moves,
+  // through whichever method was asked for
+  stream = std::make_unique<TransformStream>(GL_SHADER_STORAGE_BUFFER,
+                                             options.upload_method);
+  return stream->initialize(
+      static_cast<GLsizeiptr>(num_objects) * sizeof(glm::mat4), nullptr);
+}
+
+glm::mat4 *CulledStrategy::begin_transform_update() {
+  // the cpu tests the matrices before they are uploaded, so they are written
+  // to client memory and culling does the upload
+  if (mode != CullingMode::gpu)
+    return dynamic_model_matrices.data();
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void CulledStrategy::end_transform_update() {
+  if (mode == CullingMode::gpu) {
+    stream->unmap();
+  } else if (spatial_index) {
+    auto refit_start = std::chrono::steady_clock::now();
+    spatial_index->refit(*thread_pool, dynamic_model_matrices);
+    refit_ms = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - refit_start)
+                   .count();
+  }
+}
+
+void CulledStrategy::cull_on_gpu(const glm::mat4 &view_projection) {
+  Frustum frustum = extract_frustum(view_projection);
+
+  // the count copied by the pass that last used this slot is read back along
+  // with its timing, before the slot is reused
+  size_t slot = cull_timer->get_slot();
+  if (count_pending[slot]) {
+    glBindBuffer(GL_COPY_READ_BUFFER, count_readback_buffers[slot]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint),
+                       &gpu_visible_objects);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    count_pending[slot] = false;
+    has_visible_count = true;
+  }
+
+  // restart the count, the previous frame's draw has consumed it
+  GLuint zero = 0;
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER,
+                  offsetof(DrawIndirectCommand, instance_count),
+                  sizeof(zero), &zero);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  cull_timer->begin();
+
+  if (stream)
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream->get_buffer(),
+                      stream->get_offset(), stream->get_frame_size());
+  else
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visible_objects_ssbo);
+
+  glUseProgram(cull_program);
+  glUniform4fv(frustum_planes_location, 6,
+               glm::value_ptr(frustum.planes[0]));
+  glUniform1ui(num_objects_location, num_objects);
+  glUniform1f(bounding_radius_location, triangle_bounding_radius);
+  glBindBufferRange(GL_ATOMIC_COUNTER_BUFFER, 0, indirect_buffer,
+                    offsetof(DrawIndirectCommand, instance_count),
+                    sizeof(GLuint));
+  glDispatchCompute((num_objects + work_group_size - 1) / work_group_size, 1,
+                    1);
+
+  // the draw reads the count as its instance count and the list from the
+  // vertex shader
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+                  GL_ATOMIC_COUNTER_BARRIER_BIT);
+
+  cull_timer->end();
+
+  glBindBuffer(GL_COPY_READ_BUFFER, indirect_buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, count_readback_buffers[slot]);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                      offsetof(DrawIndirectCommand, instance_count), 0,
+                      sizeof(GLuint));
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  count_pending[slot] = true;
+}
+
+void CulledStrategy::cull_on_cpu(const glm::mat4 &view_projection) {
+  auto cull_start = std::chrono::steady_clock::now();
+  Frustum frustum = extract_frustum(view_projection);
+
+  glm::mat4 *visible = static_cast<glm::mat4 *>(stream->map());
+  visible_objects = 0;
+  for (int i = 0; visible != nullptr && i < num_objects; ++i) {
+    const glm::mat4 &model = model_matrices[i];
+    if (sphere_in_frustum(
+            frustum, glm::vec3(model[3]),
+            get_bounding_radius(model, triangle_bounding_radius)))
+      visible[visible_objects++] = model;
+  }
+  stream->unmap(visible_objects * sizeof(glm::mat4));
+
+  cpu_cull_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - cull_start)
+                    .count();
+}
+
+// the index narrows the objects down, the visible lists are then copied into
+// the stream in parallel, each list to its own offset
+void CulledStrategy::cull_with_index(const glm::mat4 &view_projection) {
+  auto cull_start = std::chrono::steady_clock::now();
+  Frustum frustum = extract_frustum(view_projection);
+
+  spatial_index->query(*thread_pool, frustum, visible_lists);
+  auto query_end = std::chrono::steady_clock::now();
+
+  std::vector<size_t> list_offsets(visible_lists.size() + 1, 0);
+  for (size_t list = 0; list < visible_lists.size(); ++list)
+    list_offsets[list + 1] = list_offsets[list] + visible_lists[list].size();
+  visible_objects = static_cast<GLsizei>(list_offsets.back());
+
+  glm::mat4 *visible = static_cast<glm::mat4 *>(stream->map());
+  if (visible == nullptr)
+    visible_objects = 0;
+  else
+    thread_pool->parallel_for(
+        visible_lists.size(),
+        [&](size_t first, size_t last) {
+          for (size_t list = first; list < last; ++list) {
+            glm::mat4 *destination = visible + list_offsets[list];
+            for (uint32_t object : visible_lists[list])
+              *destination++ = model_matrices[object];
+          }
+        },
+        1);
+  stream->unmap(visible_objects * sizeof(glm::mat4));
+
+  auto cull_end = std::chrono::steady_clock::now();
+  query_ms =
+      std::chrono::duration<double, std::milli>(query_end - cull_start).count();
+  cpu_cull_ms =
+      std::chrono::duration<double, std::milli>(cull_end - cull_start).count();
+}
+
+void CulledStrategy::draw(const FrameUniforms &uniforms) {
+  glm::mat4 view_projection = uniforms.projection * uniforms.view;
+  if (mode == CullingMode::gpu)
+    cull_on_gpu(view_projection);
+  else if (spatial_index)
+    cull_with_index(view_projection);
+  else
+    cull_on_cpu(view_projection);
+
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  glBindVertexArray(vao);
+  if (mode == CullingMode::gpu) {
+    // the matrices and the visible list are still bound from the culling pass
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    draw_object_mesh_indirect(object_mesh);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  } else if (visible_objects > 0) {
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream->get_buffer(),
+                      stream->get_offset(),
+                      visible_objects * sizeof(glm::mat4));
+    draw_object_mesh_instanced(object_mesh, visible_objects);
+  }
+  glBindVertexArray(0);
+}
+
+void CulledStrategy::record_metrics(FrameTimer &frame_timer) {
+  if (mode != CullingMode::gpu) {
+    frame_timer.record("visible_objects", visible_objects);
+    frame_timer.record("cull_ms", cpu_cull_ms);
+    if (spatial_index) {
+      frame_timer.record("query_ms", query_ms);
+      if (!dynamic_model_matrices.empty())
+        frame_timer.record("refit_ms", refit_ms);
+    }
+    return;
+  }
+  // the gpu numbers belong to a frame PassTimer::num_slots frames back, close
+  // enough for a camera that moves smoothly
+  if (has_visible_count)
+    frame_timer.record("visible_objects", gpu_visible_objects);
+  if (cull_timer->has_result())
+    frame_timer.record("gpu_cull_ms", cull_timer->latest_ms());
+}
+
+void CulledStrategy::record_run_values(FrameTimer &frame_timer) {
+  // the index is built once in initialize
+  if (spatial_index)
+    frame_timer.set_run_value("index_build_ms", index_build_ms);
+}
@@ -0,0 +1,93 @@
+#ifndef CULLED_STRATEGY_HPP
+#define CULLED_STRATEGY_HPP
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../culling/spatial_index.hpp"
+#include "pass_timer/pass_timer.hpp"
+#include "transform_strategy.hpp"
+
+enum class CullingMode {
+  // a compute pass tests every object against the frustum and appends the
+  // survivors to a list, counted by an atomic counter that is the instance
+  // count of the indirect draw
+  gpu,
+  // the cpu tests every object and uploads only the visible matrices
+  cpu,
+  // the cpu queries a spatial index built over the objects at initialize and
+  // refit whenever they move, then uploads the visible matrices
+  cpu_grid,
+  cpu_bvh,
+};
+
+// frustum culling in front of an instanced draw, the object mesh is stored once
+// and every visible object is an instance, each object's bounding sphere is
+// tested against the frustum of projection * view, needs gl 4.3 (compute
+// shaders, shader storage buffers, indirect draws)
+class CulledStrategy : public TransformStrategy {
+public:
+  explicit CulledStrategy(CullingMode mode);
+  ~CulledStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_object_mesh(MeshShape /*shape*/) const override {
+    return true;
+  }
+  void record_metrics(FrameTimer &frame_timer) override;
+  void record_run_values(FrameTimer &frame_timer) override;
+
+private:
+  static constexpr GLuint work_group_size = 256;
+
+  bool initialize_gpu_culling(const Scene &scene,
+                              const StrategyOptions &options);
+  bool initialize_cpu_culling(const Scene &scene,
+                              const StrategyOptions &options);
+  void cull_on_gpu(const glm::mat4 &view_projection);
+  void cull_on_cpu(const glm::mat4 &view_projection);
+  void cull_with_index(const glm::mat4 &view_projection);
+
+  CullingMode mode;
+  int num_objects = 0;
+  GLsizei visible_objects = 0;
+  std::unique_ptr<TransformStream> stream;
+
+  GLuint vao = 0, shader_program = 0;
+  ObjectMesh object_mesh;
+  GLint projection_location = -1, view_location = -1;
+
+  // gpu culling, the model matrices are either the static ssbo or the stream
+  GLuint ssbo = 0, visible_objects_ssbo = 0, indirect_buffer = 0,
+         cull_program = 0;
+  GLint frustum_planes_location = -1, num_objects_location = -1,
+        bounding_radius_location = -1;
+  // the pass duration, the visible count is copied into a buffer per timer
+  // slot and read back with the timing so that reporting it never waits on
+  // the gpu either
+  std::unique_ptr<PassTimer> cull_timer;
+  std::array<GLuint, PassTimer::num_slots> count_readback_buffers{};
+  std::array<bool, PassTimer::num_slots> count_pending{};
+  bool has_visible_count = false;
+  GLuint gpu_visible_objects = 0;
+
+  // cpu culling, the matrices the cpu tests, the scene's unless transforms
+  // are dynamic
+  const glm::mat4 *model_matrices = nullptr;
+  std::vector<glm::mat4> dynamic_model_matrices;
+  double cpu_cull_ms = 0.0;
+
+  // indexed cpu culling
+  ThreadPool *thread_pool = nullptr;
+  std::unique_ptr<SpatialIndex> spatial_index;
+  std::vector<std::vector<uint32_t>> visible_lists;
+  double index_build_ms = 0.0, refit_ms = 0.0, query_ms = 0.0;
+};
+
+#endif // CULLED_STRATEGY_HPP
@@ -0,0 +1,206 @@
+#include "gpu_animated_strategy.hpp"
+
+#include <array>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+
+#include "shader_utils/shader_utils.hpp"
+
+// the same oscillation as animate_model_matrices, so the cpu and gpu
+// animated runs render the same frames
+static const char *animate_compute_shader_source = R"(
+        #version 430 core
+        layout (local_size_x = 64) in;
+        layout (std430, binding = 0) readonly buffer RestPose {
+            mat4 restMatrices[];
+        };
+        layout (std430, binding = 1) writeonly buffer ModelMatrices {
+            mat4 modelMatrices[];
+        };
+        uniform float time;
+        uniform uint numObjects;
+
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (i >= numObjects)
+                return;
+            mat4 model = restMatrices[i];
+            model[3][1] += 0.05 * sin(2.0 * time + 0.37 * float(i));
+            modelMatrices[i] = model;
+        }
+    )";
+
+static const char *animate_vertex_shader_source = R"(
+        #version 330 core
+        layout (location = 0) in mat4 restMatrix; // Occupies locations 0 to 3
+        uniform float time;
+        out vec4 model0;
+        out vec4 model1;
+        out vec4 model2;
+        out vec4 model3;
+
+        void main() {
+            mat4 model = restMatrix;
+            model[3][1] += 0.05 * sin(2.0 * time + 0.37 * float(gl_VertexID));
+            model0 = model[0];
+            model1 = model[1];
+            model2 = model[2];
+            model3 = model[3];
+        }
+    )";
+
+// captured interleaved, one mat4 per point in column order
+static const std::array<const char *, 4> animate_varyings = {
+    "model0", "model1", "model2", "model3"};
+
+GpuAnimatedStrategy::~GpuAnimatedStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteVertexArrays(1, &animate_vao);
+  delete_object_mesh(object_mesh);
+  glDeleteBuffers(1, &model_buffer);
+  glDeleteBuffers(1, &rest_buffer);
+  glDeleteProgram(shader_program);
+  glDeleteProgram(animate_program);
+}
+
+bool GpuAnimatedStrategy::initialize(const Scene &scene,
+                                     const StrategyOptions &options) {
+  if (animation == GpuAnimation::compute && !GLAD_GL_VERSION_4_3) {
+    std::cerr << "gpu_animated: compute shaders and shader storage buffers "
+                 "need OpenGL 4.3"
+              << std::endl;
+    return false;
+  }
+  num_objects = scene.num_objects;
+  GLsizeiptr buffer_size =
+      static_cast<GLsizeiptr>(num_objects) * sizeof(glm::mat4);
+
+  const char *vertex_shader_source = R"(
+        #version 330 core
+        layout (location = 0) in vec3 position;
+        layout (location = 1) in mat4 model; // Occupies locations 1 to 4
+        uniform mat4 projection;
+        uniform mat4 view;
+
+        void main() {
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+  shader_program = create_shader_program(vertex_shader_source,
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+
+  // static runs draw the rest pose straight from here, dynamic runs overwrite
+  // it every frame before the draw
+  glGenBuffers(1, &model_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, model_buffer);
+  glBufferData(GL_ARRAY_BUFFER, buffer_size, scene.model_matrices.data(),
+               options.dynamic_transforms ? GL_DYNAMIC_COPY : GL_STATIC_DRAW);
+
+  if (!create_object_mesh_vao(options.object_mesh, vao, object_mesh))
+    return false;
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, model_buffer);
+  // a mat4 attribute is four vec4 columns, each advancing once per instance
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint location = 1 + column;
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          (GLvoid *)(column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  if (!options.dynamic_transforms)
+    return true;
+
+  glGenBuffers(1, &rest_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, rest_buffer);
+  glBufferData(GL_ARRAY_BUFFER, buffer_size, scene.model_matrices.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (!initialize_animation())
+    return false;
+
+  animate_timer = std::make_unique<PassTimer>();
+  return true;
+}
+
+bool GpuAnimatedStrategy::initialize_animation() {
+  if (animation == GpuAnimation::compute) {
+    animate_program = create_compute_program(animate_compute_shader_source);
+    if (animate_program == 0)
+      return false;
+    num_objects_location =
+        glGetUniformLocation(animate_program, "numObjects");
+  } else {
+    animate_program = create_transform_feedback_program(
+        animate_vertex_shader_source, animate_varyings);
+    if (animate_program == 0)
+      return false;
+
+    // one point per object, each reading its rest matrix as a per vertex
+    // attribute
+    glGenVertexArrays(1, &animate_vao);
+    glBindVertexArray(animate_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, rest_buffer);
+    for (GLuint column = 0; column < 4; ++column) {
+      glVertexAttribPointer(column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                            (GLvoid *)(column * sizeof(glm::vec4)));
+      glEnableVertexAttribArray(column);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+  time_location = glGetUniformLocation(animate_program, "time");
+  return true;
+}
+
+void GpuAnimatedStrategy::animate_transforms(float time) {
+  animate_timer->begin();
+  glUseProgram(animate_program);
+  glUniform1f(time_location, time);
+  if (animation == GpuAnimation::compute) {
+    glUniform1ui(num_objects_location, num_objects);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, rest_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, model_buffer);
+    glDispatchCompute((num_objects + workgroup_size - 1) / workgroup_size, 1,
+                      1);
+    // the draw reads the shader's writes as vertex attributes
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+  } else {
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(animate_vao);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, model_buffer);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, num_objects);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
+  animate_timer->end();
+}
+
+void GpuAnimatedStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  glBindVertexArray(vao);
+  draw_object_mesh_instanced(object_mesh, num_objects);
+  glBindVertexArray(0);
+}
+
+void GpuAnimatedStrategy::record_metrics(FrameTimer &frame_timer) {
+  // the timing belongs to a frame PassTimer::num_slots frames back
+  if (animate_timer && animate_timer->has_result())
+    frame_timer.record("animate_gpu_ms", animate_timer->latest_ms());
+}
@@ -0,0 +1,61 @@
+#ifndef GPU_ANIMATED_STRATEGY_HPP
+#define GPU_ANIMATED_STRATEGY_HPP
+
+#include <memory>
+
+#include "pass_timer/pass_timer.hpp"
+#include "transform_strategy.hpp"
+
+enum class GpuAnimation {
+  // a compute shader reads and writes the matrices as shader storage
+  // buffers, needs gl 4.3
+  compute,
+  // a vertex shader reads the matrices as a per vertex mat4 attribute and
+  // transform feedback captures its outputs with rasterization discarded,
+  // gl 3.3 core
+  transform_feedback,
+};
+
+// the scene's matrices are uploaded once, dynamic runs then move the objects
+// on the gpu: every frame a pass reads the rest pose and writes the animated
+// matrices into the buffer the draw takes its per instance mat4 attribute
+// from, so the only per frame transform data the cpu sends is the time
+class GpuAnimatedStrategy : public TransformStrategy {
+public:
+  explicit GpuAnimatedStrategy(GpuAnimation animation)
+      : animation(animation) {}
+  ~GpuAnimatedStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  // the driver calls animate_transforms instead
+  glm::mat4 *begin_transform_update() override { return nullptr; }
+  void end_transform_update() override {}
+  bool animates_on_gpu() const override { return true; }
+  void animate_transforms(float time) override;
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_object_mesh(MeshShape /*shape*/) const override {
+    return true;
+  }
+  void record_metrics(FrameTimer &frame_timer) override;
+
+private:
+  static constexpr GLuint workgroup_size = 64;
+
+  bool initialize_animation();
+
+  GpuAnimation animation;
+  int num_objects = 0;
+
+  GLuint vao = 0, model_buffer = 0, shader_program = 0;
+  ObjectMesh object_mesh;
+  GLint projection_location = -1, view_location = -1;
+
+  // dynamic runs only, the rest pose the pass reads every frame
+  GLuint rest_buffer = 0, animate_program = 0, animate_vao = 0;
+  GLint time_location = -1, num_objects_location = -1;
+
+  // the animation pass's duration
+  std::unique_ptr<PassTimer> animate_timer;
+};
+
+#endif // GPU_ANIMATED_STRATEGY_HPP
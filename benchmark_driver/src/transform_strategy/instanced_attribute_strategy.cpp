@@ -0,0 +1,102 @@
+#include "instanced_attribute_strategy.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_utils/shader_utils.hpp"
+
+InstancedAttributeStrategy::~InstancedAttributeStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  delete_object_mesh(object_mesh);
+  glDeleteBuffers(1, &instance_vbo);
+  glDeleteProgram(shader_program);
+}
+
+bool InstancedAttributeStrategy::initialize(const Scene &scene,
+                                            const StrategyOptions &options) {
+  num_objects = scene.num_objects;
+
+  const char *vertex_shader_source = R"(
+        #version 330 core
+        layout (location = 0) in vec3 position;
+        layout (location = 1) in mat4 model; // Occupies locations 1 to 4
+        uniform mat4 projection;
+        uniform mat4 view;
+
+        void main() {
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+  shader_program = create_shader_program(vertex_shader_source,
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  if (!create_object_mesh_vao(options.object_mesh, vao, object_mesh))
+    return false;
+
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_ARRAY_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(num_objects * sizeof(glm::mat4),
+                            scene.model_matrices.data()))
+      return false;
+    set_instance_attribute(stream->get_buffer(), stream->get_offset());
+  } else {
+    glGenBuffers(1, &instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, num_objects * sizeof(glm::mat4),
+                 scene.model_matrices.data(), GL_STATIC_DRAW);
+    set_instance_attribute(instance_vbo, 0);
+  }
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  return true;
+}
+
+void InstancedAttributeStrategy::set_instance_attribute(GLuint buffer,
+                                                        GLintptr offset) {
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  // a mat4 attribute is four vec4 columns, each advancing once per instance
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint location = 1 + column;
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          (GLvoid *)(offset + column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+glm::mat4 *InstancedAttributeStrategy::begin_transform_update() {
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void InstancedAttributeStrategy::end_transform_update() {
+  stream->unmap();
+  // ring methods move to a new segment every frame
+  set_instance_attribute(stream->get_buffer(), stream->get_offset());
+}
+
+size_t InstancedAttributeStrategy::update_transforms(
+    std::span<const glm::mat4> model_matrices,
+    std::span<const DirtyRange> dirty) {
+  return update_matrix_ranges(*stream, model_matrices, dirty);
+}
+
+void InstancedAttributeStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  glBindVertexArray(vao);
+  draw_object_mesh_instanced(object_mesh, num_objects);
+  glBindVertexArray(0);
+}
@@ -0,0 +1,38 @@
+#ifndef INSTANCED_ATTRIBUTE_STRATEGY_HPP
+#define INSTANCED_ATTRIBUTE_STRATEGY_HPP
+
+#include "transform_strategy.hpp"
+
+// the object mesh is stored once and drawn instanced, model
+// matrices come from a second vertex buffer as a per instance mat4 attribute
+// (glVertexAttribDivisor 1) instead of from uniform data indexed by
+// gl_VertexID
+class InstancedAttributeStrategy : public TransformStrategy {
+public:
+  ~InstancedAttributeStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                           std::span<const DirtyRange> dirty) override;
+  bool supports_change_tracking() const override { return true; }
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_object_mesh(MeshShape /*shape*/) const override {
+    return true;
+  }
+
+private:
+  // points the mat4 attribute at offset bytes into buffer
+  void set_instance_attribute(GLuint buffer, GLintptr offset);
+
+  int num_objects = 0;
+  std::unique_ptr<TransformStream> stream;
+
+  GLuint vao = 0, instance_vbo = 0, shader_program = 0;
+  ObjectMesh object_mesh;
+  GLint projection_location = -1, view_location = -1;
+};
+
+#endif // INSTANCED_ATTRIBUTE_STRATEGY_HPP
@@ -0,0 +1,184 @@
+#include "mesh_strategy.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+
+#include "shader_utils/shader_utils.hpp"
+
+static const char *mesh_vertex_shader_source = R"(
+        #version 330 core
+        layout (location = 0) in vec3 position;
+        layout (location = 1) in vec3 normal;
+        layout (location = 2) in vec2 uv;
+        layout (location = 3) in vec4 color;
+        layout (location = 4) in mat4 model; // Occupies locations 4 to 7
+        uniform mat4 projection;
+        uniform mat4 view;
+        uniform float meshScale;
+        out vec3 worldNormal;
+        out vec2 texCoord;
+        out vec4 vertexColor;
+
+        void main() {
+            gl_Position = projection * view * model *
+                          vec4(position * meshScale, 1.0);
+            // the model matrices only scale uniformly
+            worldNormal = mat3(model) * normal;
+            texCoord = uv;
+            vertexColor = color;
+        }
+    )";
+
+// uses every attribute so that none of them is optimized out of the fetch
+static const char *mesh_fragment_shader_source = R"(
+        #version 330 core
+        in vec3 worldNormal;
+        in vec2 texCoord;
+        in vec4 vertexColor;
+        out vec4 FragColor;
+
+        void main() {
+            float light = max(dot(normalize(worldNormal),
+                                  normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            float checker = mod(floor(texCoord.x * 16.0) +
+                                floor(texCoord.y * 8.0), 2.0);
+            FragColor = vec4(vertexColor.rgb * (0.3 + 0.7 * light) *
+                             (0.8 + 0.2 * checker), 1.0);
+        }
+    )";
+
+MeshStrategy::~MeshStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  delete_mesh_buffers(mesh_buffers);
+  glDeleteBuffers(1, &instance_vbo);
+  glDeleteProgram(shader_program);
+}
+
+bool MeshStrategy::initialize(const Scene &scene,
+                              const StrategyOptions &options) {
+  num_objects = scene.num_objects;
+
+  shader_program = create_shader_program(mesh_vertex_shader_source,
+                                         mesh_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  MeshShape shape = options.object_mesh.shape;
+  Mesh mesh = shape == MeshShape::triangle
+                  ? generate_sphere_mesh(sphere_rings, sphere_segments)
+                  : generate_mesh(shape, options.object_mesh.num_triangles);
+  closed = shape == MeshShape::triangle || is_closed_mesh_shape(shape);
+  if (indexing != MeshIndexing::none &&
+      !fits_index_type(mesh.vertices.size(), options.object_mesh.index_type)) {
+    std::cerr << get_index_type_name(options.object_mesh.index_type)
+              << " indices cannot address the " << mesh.vertices.size()
+              << " vertices of the mesh" << std::endl;
+    return false;
+  }
+  if (indexing == MeshIndexing::cache_optimized)
+    optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+  num_triangles = mesh.indices.size() / 3;
+  acmr = indexing == MeshIndexing::none ? 3.0 : compute_acmr(mesh.indices);
+
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  create_mesh_buffers(mesh, options.vertex_layout,
+                      indexing != MeshIndexing::none,
+                      options.object_mesh.index_type, mesh_buffers);
+  glBindVertexArray(0);
+
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_ARRAY_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(num_objects * sizeof(glm::mat4),
+                            scene.model_matrices.data()))
+      return false;
+    set_instance_attribute(stream->get_buffer(), stream->get_offset());
+  } else {
+    glGenBuffers(1, &instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, num_objects * sizeof(glm::mat4),
+                 scene.model_matrices.data(), GL_STATIC_DRAW);
+    set_instance_attribute(instance_vbo, 0);
+  }
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  mesh_scale_location = glGetUniformLocation(shader_program, "meshScale");
+  mesh_timer = std::make_unique<PassTimer>();
+  return true;
+}
+
+void MeshStrategy::set_instance_attribute(GLuint buffer, GLintptr offset) {
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  // a mat4 attribute is four vec4 columns, each advancing once per instance
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint location = 4 + column;
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          (GLvoid *)(offset + column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+glm::mat4 *MeshStrategy::begin_transform_update() {
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void MeshStrategy::end_transform_update() {
+  stream->unmap();
+  // ring methods move to a new segment every frame
+  set_instance_attribute(stream->get_buffer(), stream->get_offset());
+}
+
+size_t
+MeshStrategy::update_transforms(std::span<const glm::mat4> model_matrices,
+                                std::span<const DirtyRange> dirty) {
+  return update_matrix_ranges(*stream, model_matrices, dirty);
+}
+
+void MeshStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+  // the mesh takes up the space of the triangle it replaces
+  glUniform1f(mesh_scale_location, triangle_bounding_radius);
+
+  // closed meshes are convex, dropping their back faces makes every triangle
+  // order render the same image without a depth buffer
+  if (closed)
+    glEnable(GL_CULL_FACE);
+  mesh_timer->begin();
+  glBindVertexArray(vao);
+  if (indexing == MeshIndexing::none)
+    glDrawArraysInstanced(GL_TRIANGLES, 0, mesh_buffers.count, num_objects);
+  else
+    glDrawElementsInstanced(GL_TRIANGLES, mesh_buffers.count,
+                            mesh_buffers.index_type, nullptr, num_objects);
+  glBindVertexArray(0);
+  mesh_timer->end();
+  if (closed)
+    glDisable(GL_CULL_FACE);
+}
+
+void MeshStrategy::record_metrics(FrameTimer &frame_timer) {
+  // the timing belongs to a frame PassTimer::num_slots frames back
+  double mesh_gpu_ms = mesh_timer->latest_ms();
+  if (mesh_timer->has_result() && mesh_gpu_ms > 0.0) {
+    frame_timer.record("mesh_gpu_ms", mesh_gpu_ms);
+    frame_timer.record("mtriangles_per_s",
+                       num_triangles * num_objects / (mesh_gpu_ms * 1e3));
+  }
+}
+
+void MeshStrategy::record_run_values(FrameTimer &frame_timer) {
+  frame_timer.set_run_value("mesh_bytes", mesh_buffers.size);
+  frame_timer.set_run_value("acmr", acmr);
+}
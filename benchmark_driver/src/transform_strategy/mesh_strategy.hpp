@@ -0,0 +1,71 @@
+#ifndef MESH_STRATEGY_HPP
+#define MESH_STRATEGY_HPP
+
+#include <memory>
+
+#include "../mesh/mesh.hpp"
+#include "../vertex_layout/vertex_layout.hpp"
+#include "pass_timer/pass_timer.hpp"
+#include "transform_strategy.hpp"
+
+enum class MeshIndexing {
+  // every triangle has three vertices of its own, glDrawArraysInstanced
+  none,
+  // glDrawElementsInstanced with the triangles in generation order
+  indexed,
+  // the same indices reordered for the post transform vertex cache
+  cache_optimized,
+};
+
+// every object draws a mesh with normals, uvs and colors in the run's vertex
+// layout instead of the triangle, the run's object mesh or a sphere when that
+// is the triangle, the mesh is stored once and drawn instanced with the model
+// matrices as a per instance mat4 attribute like instanced_attribute, so runs
+// differ only in how vertices are fetched
+class MeshStrategy : public TransformStrategy {
+public:
+  explicit MeshStrategy(MeshIndexing indexing) : indexing(indexing) {}
+  ~MeshStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                           std::span<const DirtyRange> dirty) override;
+  bool supports_change_tracking() const override { return true; }
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_vertex_layout(VertexLayout /*layout*/) const override {
+    return true;
+  }
+  // the triangle stands for the default sphere
+  bool supports_object_mesh(MeshShape /*shape*/) const override {
+    return true;
+  }
+  void record_metrics(FrameTimer &frame_timer) override;
+  void record_run_values(FrameTimer &frame_timer) override;
+
+private:
+  // 960 triangles over 561 vertices, for runs without an object mesh
+  static constexpr int sphere_rings = 16;
+  static constexpr int sphere_segments = 32;
+
+  void set_instance_attribute(GLuint buffer, GLintptr offset);
+
+  MeshIndexing indexing;
+  int num_objects = 0;
+  size_t num_triangles = 0;
+  bool closed = true;
+  double acmr = 0.0;
+  std::unique_ptr<TransformStream> stream;
+
+  GLuint vao = 0, instance_vbo = 0, shader_program = 0;
+  GLint projection_location = -1, view_location = -1,
+        mesh_scale_location = -1;
+  MeshBuffers mesh_buffers;
+
+  // the draw's duration
+  std::unique_ptr<PassTimer> mesh_timer;
+};
+
+#endif // MESH_STRATEGY_HPP
@@ -0,0 +1,185 @@
+#include "multi_draw_strategy.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "gl_extensions/gl_extensions.hpp"
+#include "shader_utils/shader_utils.hpp"
+
+MultiDrawStrategy::MultiDrawStrategy(DrawSubmission submission)
+    : submission(submission) {}
+
+MultiDrawStrategy::~MultiDrawStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ssbo);
+  glDeleteBuffers(1, &indirect_buffer);
+  glDeleteBuffers(1, &object_index_vbo);
+  glDeleteProgram(shader_program);
+}
+
+bool MultiDrawStrategy::initialize(const Scene &scene,
+                                   const StrategyOptions &options) {
+  if (!GLAD_GL_VERSION_4_3) {
+    std::cerr << "multi draw: shader storage buffers and indirect multi draws "
+                 "need OpenGL 4.3"
+              << std::endl;
+    return false;
+  }
+  if (submission == DrawSubmission::indirect_draw_id &&
+      !has_gl_extension("GL_ARB_shader_draw_parameters")) {
+    std::cerr << "multi draw: gl_DrawIDARB needs "
+                 "GL_ARB_shader_draw_parameters"
+              << std::endl;
+    return false;
+  }
+
+  num_objects = scene.num_objects;
+  GLint64 buffer_size = static_cast<GLint64>(num_objects) * sizeof(glm::mat4);
+
+  GLint64 max_block_size;
+  glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+  if (buffer_size > max_block_size) {
+    std::cerr << "multi draw: " << buffer_size
+              << " bytes of matrices exceed GL_MAX_SHADER_STORAGE_BLOCK_SIZE ("
+              << max_block_size << " bytes)" << std::endl;
+    return false;
+  }
+
+  create_expanded_triangle_vao(num_objects, vao, vbo);
+
+  std::string header = "#version 430 core\n";
+  std::string object_index;
+  switch (submission) {
+  case DrawSubmission::individual_draws:
+    header += "uniform int objectIndex;\n";
+    object_index = "objectIndex";
+    break;
+  case DrawSubmission::indirect_draw_id:
+    header += "#extension GL_ARB_shader_draw_parameters : require\n";
+    object_index = "gl_DrawIDARB";
+    break;
+  case DrawSubmission::indirect_base_instance:
+    header += "layout (location = 1) in uint instanceObjectIndex;\n";
+    object_index = "int(instanceObjectIndex)";
+    break;
+  }
+
+  std::string vertex_shader_source =
+      header +
+      "layout (location = 0) in vec3 position;\n"
+      "uniform mat4 projection;\n"
+      "uniform mat4 view;\n"
+      "layout(std430, binding = 0) readonly buffer ModelMatrices {\n"
+      "    mat4 modelMatrices[];\n"
+      "};\n"
+      "void main() {\n"
+      "    gl_Position = projection * view * modelMatrices[" +
+      object_index +
+      "] * vec4(position, 1.0);\n"
+      "}\n";
+
+  shader_program = create_shader_program(vertex_shader_source.c_str(),
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  if (submission != DrawSubmission::individual_draws)
+    create_indirect_buffer();
+  if (submission == DrawSubmission::indirect_base_instance)
+    create_object_index_attribute();
+
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_SHADER_STORAGE_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(buffer_size, scene.model_matrices.data()))
+      return false;
+  } else {
+    glGenBuffers(1, &ssbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_size,
+                 scene.model_matrices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  object_index_location = glGetUniformLocation(shader_program, "objectIndex");
+  return true;
+}
+
+// one command per object, written once, the commands stay in gpu memory and
+// the draw only passes the buffer offset
+void MultiDrawStrategy::create_indirect_buffer() {
+  std::vector<DrawArraysIndirectCommand> commands(num_objects);
+  for (int i = 0; i < num_objects; ++i)
+    commands[i] = {3, 1, static_cast<GLuint>(3 * i), static_cast<GLuint>(i)};
+
+  glGenBuffers(1, &indirect_buffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               commands.size() * sizeof(DrawArraysIndirectCommand),
+               commands.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// instanced attributes are fetched at base_instance + gl_InstanceID, so an
+// attribute holding 0 .. n - 1 turns each command's base instance into its
+// object index
+void MultiDrawStrategy::create_object_index_attribute() {
+  std::vector<GLuint> object_indices(num_objects);
+  std::iota(object_indices.begin(), object_indices.end(), 0u);
+
+  glBindVertexArray(vao);
+  glGenBuffers(1, &object_index_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, object_index_vbo);
+  glBufferData(GL_ARRAY_BUFFER, object_indices.size() * sizeof(GLuint),
+               object_indices.data(), GL_STATIC_DRAW);
+  glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), (GLvoid *)0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribDivisor(1, 1);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+glm::mat4 *MultiDrawStrategy::begin_transform_update() {
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void MultiDrawStrategy::end_transform_update() { stream->unmap(); }
+
+size_t
+MultiDrawStrategy::update_transforms(std::span<const glm::mat4> model_matrices,
+                                     std::span<const DirtyRange> dirty) {
+  return update_matrix_ranges(*stream, model_matrices, dirty);
+}
+
+void MultiDrawStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  if (stream)
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream->get_buffer(),
+                      stream->get_offset(), stream->get_frame_size());
+  else
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
+
+  glBindVertexArray(vao);
+  if (submission == DrawSubmission::individual_draws) {
+    for (int i = 0; i < num_objects; ++i) {
+      glUniform1i(object_index_location, i);
+      glDrawArrays(GL_TRIANGLES, 3 * i, 3);
+    }
+  } else {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, num_objects, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+  glBindVertexArray(0);
+}
@@ -0,0 +1,62 @@
+#ifndef MULTI_DRAW_STRATEGY_HPP
+#define MULTI_DRAW_STRATEGY_HPP
+
+#include "transform_strategy.hpp"
+
+// how the per object draws reach the gpu and how the vertex shader finds out
+// which object it is drawing
+enum class DrawSubmission {
+  // one glDrawArrays per object with the object index set as a uniform in
+  // between, what a naive engine loop does
+  individual_draws,
+  // a single glMultiDrawArraysIndirect over one command per object, the index
+  // is gl_DrawIDARB (ARB_shader_draw_parameters)
+  indirect_draw_id,
+  // the same indirect draw, each command's baseInstance is the object index,
+  // read back through a per instance attribute since gl_InstanceID does not
+  // include the base instance
+  indirect_base_instance,
+};
+
+// every object is drawn as a draw of its own, as if each were a distinct mesh
+// living in a shared vertex buffer (object i is vertices 3 i .. 3 i + 2),
+// the matrices are in a std430 shader storage buffer as in SsboStrategy and
+// the shader never derives the object from gl_VertexID, needs gl 4.3
+class MultiDrawStrategy : public TransformStrategy {
+public:
+  explicit MultiDrawStrategy(DrawSubmission submission);
+  ~MultiDrawStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                           std::span<const DirtyRange> dirty) override;
+  bool supports_change_tracking() const override { return true; }
+  void draw(const FrameUniforms &uniforms) override;
+  int get_draws_per_frame() const override { return num_objects; }
+
+private:
+  // matches the layout glMultiDrawArraysIndirect reads
+  struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first;
+    GLuint base_instance;
+  };
+
+  void create_indirect_buffer();
+  void create_object_index_attribute();
+
+  DrawSubmission submission;
+  int num_objects = 0;
+  std::unique_ptr<TransformStream> stream;
+
+  GLuint vao = 0, vbo = 0, ssbo = 0, indirect_buffer = 0,
+         object_index_vbo = 0, shader_program = 0;
+  GLint projection_location = -1, view_location = -1,
+        object_index_location = -1;
+};
+
+#endif // MULTI_DRAW_STRATEGY_HPP
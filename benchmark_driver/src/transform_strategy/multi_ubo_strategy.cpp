@@ -0,0 +1,155 @@
+#include "multi_ubo_strategy.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "shader_utils/shader_utils.hpp"
+
+MultiUboStrategy::~MultiUboStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ubo);
+}
+
+// like ubo_shard_vertex_shader_template but every shard is a uvec4 array
+// holding the objects in the encoding ENCODING selects, the switch only loads
+// the object's data, decoding happens once after it, INDEXING picks where the
+// object index comes from
+static const std::string encoded_vertex_shader_source =
+    std::string("#version 330 core\n") + transform_decode_glsl + R"(
+        #define INDEXING_VERTEX_ID 0
+        #define INDEXING_INSTANCE_ID 1
+
+        layout (location = 0) in vec3 position;
+        uniform mat4 projection;
+        uniform mat4 view;
+        layout(std140) uniform ModelMatrices {
+            uvec4 data[TRANSFORM_DATA_VEC4S(OBJECTS_PER_SHARD)];
+        } shards[NUM_SHARDS];
+
+        #define SELECT(k) case k: FETCH_TRANSFORM(shards[k].data, slot) break;
+
+        void main() {
+        #if INDEXING == INDEXING_INSTANCE_ID
+            int objectIndex = gl_InstanceID;
+        #else
+            int objectIndex = gl_VertexID / 3;
+        #endif
+            int shard = objectIndex / OBJECTS_PER_SHARD;
+            int slot = objectIndex - shard * OBJECTS_PER_SHARD;
+            uvec4 transform[transformVec4s];
+            switch (shard) {)" + ubo_shard_select_cases_glsl + R"(
+            }
+            gl_Position = projection * view *
+                          vec4(applyTransform(transform, position), 1.0);
+        }
+    )";
+
+static const ShaderTemplate encoded_shader_template = {
+    "multi_ubo", encoded_vertex_shader_source.c_str(),
+    scene_fragment_shader_source};
+
+bool MultiUboStrategy::initialize(const Scene &scene,
+                                  const StrategyOptions &options) {
+  encoding = options.transform_encoding;
+  thread_pool = options.thread_pool;
+  if (is_half_precision(encoding) && !GLAD_GL_VERSION_4_2) {
+    std::cerr << "multi_ubo: half precision transforms need OpenGL 4.2"
+              << std::endl;
+    return false;
+  }
+  if (!compute_ubo_shard_layout(scene.num_objects, layout,
+                                get_encoded_transform_size(encoding)))
+    return false;
+
+  std::cout << "multi_ubo: " << layout.num_shards << " uniform blocks of "
+            << layout.objects_per_shard << " "
+            << get_transform_encoding_name(encoding) << " transforms"
+            << std::endl;
+
+  create_expanded_triangle_vao(scene.num_objects, vao, vbo);
+
+  ShaderDefines defines = get_ubo_shard_defines(layout);
+  set_transform_encoding_define(defines, encoding);
+  defines.set_symbol("INDEXING", "INDEXING_VERTEX_ID");
+  size_t variant = shader_variants.add(encoded_shader_template, defines);
+  if (!shader_variants.build())
+    return false;
+  shader_program = shader_variants.get_program(variant);
+
+  // a streamed frame covers the padding of the last shard too so that every
+  // shard range stays inside the frame
+  std::vector<std::byte> encoded_transforms(layout.buffer_size);
+  encode_transforms(*thread_pool, encoding, scene.model_matrices,
+                    encoded_transforms.data());
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_UNIFORM_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(layout.buffer_size, encoded_transforms.data()))
+      return false;
+    if (encoding != TransformEncoding::mat4)
+      staged_matrices.resize(scene.num_objects);
+    if (stream->supports_range_updates())
+      this->encoded_transforms = std::move(encoded_transforms);
+  } else {
+    ubo = create_ubo_shard_buffer(layout, encoded_transforms.data());
+  }
+  bind_ubo_shard_blocks(shader_program, layout);
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  return true;
+}
+
+glm::mat4 *MultiUboStrategy::begin_transform_update() {
+  if (encoding != TransformEncoding::mat4)
+    return staged_matrices.data();
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void MultiUboStrategy::end_transform_update() {
+  if (encoding != TransformEncoding::mat4) {
+    if (void *mapping = stream->map())
+      encode_transforms(*thread_pool, encoding, staged_matrices, mapping);
+  }
+  stream->unmap();
+}
+
+size_t MultiUboStrategy::update_transforms(
+    std::span<const glm::mat4> model_matrices,
+    std::span<const DirtyRange> dirty) {
+  if (encoded_transforms.empty()) {
+    TransformStrategy::update_transforms(model_matrices, dirty);
+    // every shard goes up in full, padding included
+    return stream->get_frame_size();
+  }
+
+  // the shards sit back to back without gaps, so object i starts
+  // i * object_size bytes into the frame whichever shard holds it
+  size_t object_size = layout.object_size;
+  for (const DirtyRange &range : dirty)
+    encode_transforms(*thread_pool, encoding,
+                      model_matrices.subspan(range.first, range.count),
+                      encoded_transforms.data() + range.first * object_size);
+  return stream->update_object_ranges(encoded_transforms.data(), dirty,
+                                      object_size);
+}
+
+void MultiUboStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  if (stream)
+    bind_ubo_shard_ranges(stream->get_buffer(), layout, stream->get_offset());
+  else
+    bind_ubo_shard_ranges(ubo, layout);
+
+  glBindVertexArray(vao);
+  glDrawArrays(GL_TRIANGLES, 0, 3 * layout.num_objects);
+  glBindVertexArray(0);
+}
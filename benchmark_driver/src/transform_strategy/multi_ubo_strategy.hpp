@@ -0,0 +1,50 @@
+#ifndef MULTI_UBO_STRATEGY_HPP
+#define MULTI_UBO_STRATEGY_HPP
+
+#include "shader_variants/shader_variants.hpp"
+#include "transform_strategy.hpp"
+#include "ubo_sharding/ubo_sharding.hpp"
+
+// the transforms_in_uniform_buffer_object approach, model matrices are
+// uploaded once into as many std140 uniform blocks as the object count needs
+// and the vertex shader picks the block from gl_VertexID / 3, everything is
+// drawn with one call, with dynamic transforms the shards are streamed
+// through a TransformStream instead, a compact TransformEncoding fits
+// proportionally more objects into each block
+class MultiUboStrategy : public TransformStrategy {
+public:
+  ~MultiUboStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                           std::span<const DirtyRange> dirty) override;
+  bool supports_change_tracking() const override { return true; }
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_transform_encoding(
+      TransformEncoding /*encoding*/) const override {
+    return true;
+  }
+
+private:
+  UboShardLayout layout;
+  TransformEncoding encoding = TransformEncoding::mat4;
+  std::unique_ptr<TransformStream> stream;
+  // dynamic runs with a compact encoding, the driver writes mat4s here and
+  // end_transform_update encodes them into the stream
+  ThreadPool *thread_pool = nullptr;
+  std::vector<glm::mat4> staged_matrices;
+  // dynamic runs whose upload method can update ranges, the encoded image of
+  // every shard, update_transforms re-encodes and uploads the dirty objects'
+  // bytes of it
+  std::vector<std::byte> encoded_transforms;
+
+  // owns shader_program
+  ShaderVariantSet shader_variants;
+  GLuint vao = 0, vbo = 0, ubo = 0, shader_program = 0;
+  GLint projection_location = -1, view_location = -1;
+};
+
+#endif // MULTI_UBO_STRATEGY_HPP
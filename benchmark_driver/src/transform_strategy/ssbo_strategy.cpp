@@ -0,0 +1,154 @@
+#include "ssbo_strategy.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shader_utils/shader_utils.hpp"
+
+SsboStrategy::SsboStrategy(bool instanced) : instanced(instanced) {}
+
+SsboStrategy::~SsboStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  delete_object_mesh(object_mesh);
+  glDeleteBuffers(1, &ssbo);
+  glDeleteProgram(shader_program);
+}
+
+bool SsboStrategy::initialize(const Scene &scene,
+                              const StrategyOptions &options) {
+  if (!GLAD_GL_VERSION_4_3) {
+    std::cerr << "ssbo: shader storage buffers need OpenGL 4.3" << std::endl;
+    return false;
+  }
+
+  num_objects = scene.num_objects;
+  encoding = options.transform_encoding;
+  thread_pool = options.thread_pool;
+  if (is_half_precision(encoding) && !GLAD_GL_VERSION_4_2) {
+    std::cerr << "ssbo: half precision transforms need OpenGL 4.2"
+              << std::endl;
+    return false;
+  }
+  GLint64 buffer_size = get_encoded_buffer_size(encoding, num_objects);
+
+  GLint64 max_block_size;
+  glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+  if (buffer_size > max_block_size) {
+    std::cerr << "ssbo: " << buffer_size
+              << " bytes of transforms exceed "
+                 "GL_MAX_SHADER_STORAGE_BLOCK_SIZE ("
+              << max_block_size << " bytes)" << std::endl;
+    return false;
+  }
+
+  if (!instanced)
+    create_expanded_triangle_vao(num_objects, vao, vbo);
+  else if (!create_object_mesh_vao(options.object_mesh, vao, object_mesh))
+    return false;
+
+  std::string object_index = instanced ? "gl_InstanceID" : "gl_VertexID / 3";
+  std::string vertex_shader_source =
+      "#version 430 core\n"
+      "layout (location = 0) in vec3 position;\n"
+      "uniform mat4 projection;\n"
+      "uniform mat4 view;\n"
+      "layout(std430, binding = 0) readonly buffer Transforms {\n"
+      "    uvec4 transformData[];\n"
+      "};\n" +
+      get_transform_decode_glsl(encoding) +
+      "void main() {\n"
+      "    int triangleIndex = " +
+      object_index +
+      ";\n"
+      "    uvec4 transform[transformVec4s];\n" +
+      get_transform_fetch_glsl("transformData", "triangleIndex") +
+      "    gl_Position = projection * view * "
+      "vec4(applyTransform(transform, position), 1.0);\n"
+      "}\n";
+
+  shader_program = create_shader_program(vertex_shader_source.c_str(),
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  std::vector<std::byte> encoded_transforms(buffer_size);
+  encode_transforms(*thread_pool, encoding, scene.model_matrices,
+                    encoded_transforms.data());
+
+  if (options.dynamic_transforms) {
+    stream = std::make_unique<TransformStream>(GL_SHADER_STORAGE_BUFFER,
+                                               options.upload_method);
+    if (!stream->initialize(buffer_size, encoded_transforms.data()))
+      return false;
+    if (encoding != TransformEncoding::mat4)
+      staged_matrices.resize(num_objects);
+    if (stream->supports_range_updates())
+      this->encoded_transforms = std::move(encoded_transforms);
+  } else {
+    glGenBuffers(1, &ssbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_size,
+                 encoded_transforms.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  }
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  return true;
+}
+
+glm::mat4 *SsboStrategy::begin_transform_update() {
+  if (encoding != TransformEncoding::mat4)
+    return staged_matrices.data();
+  return static_cast<glm::mat4 *>(stream->map());
+}
+
+void SsboStrategy::end_transform_update() {
+  if (encoding != TransformEncoding::mat4) {
+    if (void *mapping = stream->map())
+      encode_transforms(*thread_pool, encoding, staged_matrices, mapping);
+  }
+  stream->unmap();
+}
+
+size_t
+SsboStrategy::update_transforms(std::span<const glm::mat4> model_matrices,
+                                std::span<const DirtyRange> dirty) {
+  if (encoded_transforms.empty()) {
+    TransformStrategy::update_transforms(model_matrices, dirty);
+    return stream->get_frame_size();
+  }
+
+  size_t object_size = get_encoded_transform_size(encoding);
+  for (const DirtyRange &range : dirty)
+    encode_transforms(*thread_pool, encoding,
+                      model_matrices.subspan(range.first, range.count),
+                      encoded_transforms.data() + range.first * object_size);
+  return stream->update_object_ranges(encoded_transforms.data(), dirty,
+                                      object_size);
+}
+
+void SsboStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  if (stream)
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream->get_buffer(),
+                      stream->get_offset(), stream->get_frame_size());
+  else
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
+
+  glBindVertexArray(vao);
+  if (instanced)
+    draw_object_mesh_instanced(object_mesh, num_objects);
+  else
+    glDrawArrays(GL_TRIANGLES, 0, 3 * num_objects);
+  glBindVertexArray(0);
+}
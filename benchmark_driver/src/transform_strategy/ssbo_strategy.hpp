@@ -0,0 +1,52 @@
+#ifndef SSBO_STRATEGY_HPP
+#define SSBO_STRATEGY_HPP
+
+#include "transform_strategy.hpp"
+
+// model matrices uploaded once into a single std430 shader storage buffer
+// (gl 4.3), which has no practical size limit, the object index is either
+// gl_VertexID / 3 over the expanded triangle buffer or gl_InstanceID with the
+// object mesh stored once and drawn instanced, the transforms can be stored in
+// any TransformEncoding
+class SsboStrategy : public TransformStrategy {
+public:
+  explicit SsboStrategy(bool instanced);
+  ~SsboStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  bool has_failed() const override { return stream && stream->has_failed(); }
+  size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                           std::span<const DirtyRange> dirty) override;
+  bool supports_change_tracking() const override { return true; }
+  void draw(const FrameUniforms &uniforms) override;
+  bool supports_transform_encoding(
+      TransformEncoding /*encoding*/) const override {
+    return true;
+  }
+  bool supports_object_mesh(MeshShape shape) const override {
+    return instanced || shape == MeshShape::triangle;
+  }
+
+private:
+  bool instanced;
+  int num_objects = 0;
+  TransformEncoding encoding = TransformEncoding::mat4;
+  std::unique_ptr<TransformStream> stream;
+  // dynamic runs with a compact encoding, the driver writes mat4s here and
+  // end_transform_update encodes them into the stream
+  ThreadPool *thread_pool = nullptr;
+  std::vector<glm::mat4> staged_matrices;
+  // dynamic runs whose upload method can update ranges, the encoded image of
+  // the whole buffer, update_transforms re-encodes and uploads the dirty
+  // objects' bytes of it
+  std::vector<std::byte> encoded_transforms;
+
+  // vbo holds the expanded triangle, object_mesh what instanced runs draw
+  GLuint vao = 0, vbo = 0, ssbo = 0, shader_program = 0;
+  ObjectMesh object_mesh;
+  GLint projection_location = -1, view_location = -1;
+};
+
+#endif // SSBO_STRATEGY_HPP
@@ -0,0 +1,135 @@
+#include "transform_strategy.hpp"
+
+#include <algorithm>
+
+#include "culled_strategy.hpp"
+#include "gpu_animated_strategy.hpp"
+#include "instanced_attribute_strategy.hpp"
+#include "mesh_strategy.hpp"
+#include "multi_draw_strategy.hpp"
+#include "multi_ubo_strategy.hpp"
+#include "ssbo_strategy.hpp"
+#include "uniform_array_strategy.hpp"
+
+size_t
+TransformStrategy::update_transforms(std::span<const glm::mat4> model_matrices,
+                                     std::span<const DirtyRange> /*dirty*/) {
+  glm::mat4 *destination = begin_transform_update();
+  if (destination != nullptr)
+    std::copy(model_matrices.begin(), model_matrices.end(), destination);
+  end_transform_update();
+  return model_matrices.size_bytes();
+}
+
+size_t TransformStrategy::update_matrix_ranges(
+    TransformStream &stream, std::span<const glm::mat4> model_matrices,
+    std::span<const DirtyRange> dirty) {
+  if (!stream.supports_range_updates())
+    return TransformStrategy::update_transforms(model_matrices, dirty);
+  return stream.update_object_ranges(model_matrices.data(), dirty,
+                                     sizeof(glm::mat4));
+}
+
+template <typename Strategy>
+static std::unique_ptr<TransformStrategy> make_strategy() {
+  return std::make_unique<Strategy>();
+}
+
+const std::vector<StrategyRegistration> &get_strategy_registry() {
+  static const std::vector<StrategyRegistration> registry = {
+      {"uniform_array",
+       "model matrices re-uploaded every frame into a uniform mat4 array, "
+       "drawn in batches that fit the uniform limit",
+       make_strategy<UniformArrayStrategy>},
+      {"multi_ubo",
+       "model matrices sharded across as many uniform blocks as "
+       "GL_MAX_UNIFORM_BLOCK_SIZE requires, one draw call",
+       make_strategy<MultiUboStrategy>},
+      {"ssbo",
+       "model matrices in one std430 shader storage buffer indexed by "
+       "gl_VertexID / 3, needs gl 4.3",
+       [] { return std::make_unique<SsboStrategy>(false); }},
+      {"ssbo_instanced",
+       "model matrices in one std430 shader storage buffer indexed by "
+       "gl_InstanceID, the object mesh is stored once, needs gl 4.3",
+       [] { return std::make_unique<SsboStrategy>(true); }},
+      {"instanced_attribute",
+       "object mesh stored once, model matrices streamed as a per instance "
+       "mat4 vertex attribute, one instanced draw call",
+       make_strategy<InstancedAttributeStrategy>},
+      {"individual_draws",
+       "one glDrawArrays per object with its index set as a uniform, the "
+       "baseline for per draw submission cost, needs gl 4.3",
+       [] {
+         return std::make_unique<MultiDrawStrategy>(
+             DrawSubmission::individual_draws);
+       }},
+      {"mdi_draw_id",
+       "one glMultiDrawArraysIndirect over a gpu resident command per object, "
+       "matrices indexed by gl_DrawIDARB, needs gl 4.3 and "
+       "ARB_shader_draw_parameters",
+       [] {
+         return std::make_unique<MultiDrawStrategy>(
+             DrawSubmission::indirect_draw_id);
+       }},
+      {"mdi_base_instance",
+       "one glMultiDrawArraysIndirect over a gpu resident command per object, "
+       "matrices indexed through each command's base instance, needs gl 4.3",
+       [] {
+         return std::make_unique<MultiDrawStrategy>(
+             DrawSubmission::indirect_base_instance);
+       }},
+      {"gpu_culled",
+       "a compute pass culls every object against the frustum and appends "
+       "the survivors for one instanced indirect draw, needs gl 4.3",
+       [] { return std::make_unique<CulledStrategy>(CullingMode::gpu); }},
+      {"cpu_culled",
+       "the cpu culls every object against the frustum and uploads only the "
+       "visible matrices for one instanced draw, needs gl 4.3",
+       [] { return std::make_unique<CulledStrategy>(CullingMode::cpu); }},
+      {"cpu_culled_grid",
+       "like cpu_culled but queries a uniform grid over the objects, built in "
+       "parallel and refit when they move, needs gl 4.3",
+       [] { return std::make_unique<CulledStrategy>(CullingMode::cpu_grid); }},
+      {"cpu_culled_bvh",
+       "like cpu_culled but queries a flat morton ordered bvh over the "
+       "objects, built in parallel and refit when they move, needs gl 4.3",
+       [] { return std::make_unique<CulledStrategy>(CullingMode::cpu_bvh); }},
+      {"mesh_arrays",
+       "a sphere (or the --mesh) with normals, uvs and colors in the "
+       "--vertex-layout, expanded to three vertices per triangle, one "
+       "instanced draw",
+       [] { return std::make_unique<MeshStrategy>(MeshIndexing::none); }},
+      {"mesh_indexed",
+       "the mesh drawn with glDrawElementsInstanced, triangles in "
+       "generation order",
+       [] { return std::make_unique<MeshStrategy>(MeshIndexing::indexed); }},
+      {"mesh_cache_optimized",
+       "the mesh drawn indexed, triangles reordered for the post "
+       "transform vertex cache",
+       [] {
+         return std::make_unique<MeshStrategy>(MeshIndexing::cache_optimized);
+       }},
+      {"gpu_animated",
+       "matrices uploaded once, a compute pass animates them on the gpu "
+       "every frame into the per instance mat4 attribute, needs gl 4.3",
+       [] {
+         return std::make_unique<GpuAnimatedStrategy>(GpuAnimation::compute);
+       }},
+      {"gpu_animated_tf",
+       "like gpu_animated but the pass is a vertex shader captured by "
+       "transform feedback with rasterization discarded, gl 3.3",
+       [] {
+         return std::make_unique<GpuAnimatedStrategy>(
+             GpuAnimation::transform_feedback);
+       }},
+  };
+  return registry;
+}
+
+std::unique_ptr<TransformStrategy> create_strategy(const std::string &name) {
+  for (const StrategyRegistration &registration : get_strategy_registry())
+    if (registration.name == name)
+      return registration.create();
+  return nullptr;
+}
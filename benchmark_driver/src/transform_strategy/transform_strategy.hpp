@@ -0,0 +1,143 @@
+#ifndef TRANSFORM_STRATEGY_HPP
+#define TRANSFORM_STRATEGY_HPP
+
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "dirty_tracker/dirty_tracker.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "../object_mesh/object_mesh.hpp"
+#include "../scene/scene.hpp"
+#include "../transform_encoding/transform_encoding.hpp"
+#include "../transform_stream/transform_stream.hpp"
+#include "../vertex_layout/vertex_layout.hpp"
+
+struct StrategyOptions {
+  // every frame the driver rewrites all model matrices through
+  // begin_transform_update / end_transform_update before drawing
+  bool dynamic_transforms = false;
+  // how strategies backed by a buffer object get those matrices to the gpu
+  UploadMethod upload_method = UploadMethod::buffer_sub_data;
+  // how each object's transform is stored on the gpu, only strategies whose
+  // supports_transform_encoding accepts it are run with anything but mat4
+  TransformEncoding transform_encoding = TransformEncoding::mat4;
+  // how strategies that draw a mesh store its vertices, the triangle every
+  // other strategy draws is plain float positions, which counts as aos_float
+  VertexLayout vertex_layout = VertexLayout::aos_float;
+  // what each object draws, only strategies whose supports_object_mesh
+  // accepts the shape are run with anything but the triangle
+  ObjectMeshOptions object_mesh;
+  // the driver's pool, for strategies with cpu side work worth spreading
+  // across cores, set by the driver before initialize
+  ThreadPool *thread_pool = nullptr;
+};
+
+// one way of getting per object model matrices to the vertex shader, the
+// driver owns the context, the scene and the timing, a strategy owns every gl
+// object it creates and releases them in its destructor (the context is still
+// current at that point)
+class TransformStrategy {
+public:
+  virtual ~TransformStrategy() = default;
+
+  // creates buffers and programs for the scene, returns false and logs the
+  // reason when the scene does not fit the strategy or the context lacks a
+  // required feature, the scene outlives the strategy
+  virtual bool initialize(const Scene &scene,
+                          const StrategyOptions &options) = 0;
+
+  // dynamic runs only, returns where the driver writes this frame's
+  // scene.num_objects matrices, which may be gpu memory, nullptr when a
+  // buffer could not be mapped (has_failed is then true), the driver still
+  // calls end_transform_update
+  virtual glm::mat4 *begin_transform_update() = 0;
+  // makes the matrices written since begin_transform_update visible to the
+  // next draw
+  virtual void end_transform_update() = 0;
+
+  // dynamic runs that track changes only, in place of
+  // begin/end_transform_update: model_matrices holds every object's current
+  // matrix and only the objects in dirty changed since the last call (or
+  // since initialize), returns the bytes uploaded, the default writes every
+  // matrix through begin/end_transform_update and counts them all as mat4s,
+  // strategies storing another encoding report what they actually upload
+  virtual size_t update_transforms(std::span<const glm::mat4> model_matrices,
+                                   std::span<const DirtyRange> dirty);
+  // whether an upload failed since initialize because a buffer could not be
+  // mapped, the reason has been logged, the driver ends the run as failed
+  // rather than measuring frames drawn with stale transforms
+  virtual bool has_failed() const { return false; }
+
+  // whether update_transforms uploads only the dirty objects when the upload
+  // method can update ranges, the driver rejects change tracking runs of
+  // strategies that would upload every matrix anyway
+  virtual bool supports_change_tracking() const { return false; }
+
+  // strategies that move the objects themselves on the gpu, the driver calls
+  // animate_transforms every frame of a dynamic run in place of
+  // begin/end_transform_update and never writes matrices
+  virtual bool animates_on_gpu() const { return false; }
+  // issues the gpu work moving every object to where it is at time, the
+  // matrices it writes are visible to the next draw
+  virtual void animate_transforms(float /*time*/) {}
+
+  // issues everything needed to draw the whole scene for one frame, the
+  // framebuffer has already been cleared
+  virtual void draw(const FrameUniforms &uniforms) = 0;
+
+  // how many draws one call to draw submits, counting every command of an
+  // indirect multi draw, the driver divides the submission time by it
+  virtual int get_draws_per_frame() const { return 1; }
+
+  // whether initialize accepts the encoding, the driver writes mat4s through
+  // begin_transform_update regardless and the strategy encodes them
+  virtual bool supports_transform_encoding(TransformEncoding encoding) const {
+    return encoding == TransformEncoding::mat4;
+  }
+
+  // whether initialize accepts the vertex layout
+  virtual bool supports_vertex_layout(VertexLayout layout) const {
+    return layout == VertexLayout::aos_float;
+  }
+
+  // whether initialize accepts the object mesh shape, strategies drawing one
+  // instance per object take any of them, the ones drawing a buffer with the
+  // triangle expanded once per object only the triangle
+  virtual bool supports_object_mesh(MeshShape shape) const {
+    return shape == MeshShape::triangle;
+  }
+
+  // called once per frame after draw, strategies with measurements of their
+  // own (culling results, pass timings) record them here
+  virtual void record_metrics(FrameTimer &/*frame_timer*/) {}
+
+  // called once after the last frame for measurements that do not change
+  // from frame to frame (buffer sizes, one time build costs)
+  virtual void record_run_values(FrameTimer &/*frame_timer*/) {}
+
+protected:
+  // update_transforms for strategies streaming plain mat4s back to back, the
+  // matrices are their own frame image so only the dirty ones are uploaded,
+  // upload methods without range updates fall back to the default
+  size_t update_matrix_ranges(TransformStream &stream,
+                              std::span<const glm::mat4> model_matrices,
+                              std::span<const DirtyRange> dirty);
+};
+
+struct StrategyRegistration {
+  std::string name;
+  std::string description;
+  std::function<std::unique_ptr<TransformStrategy>()> create;
+};
+
+// every strategy the driver knows about, adding a strategy means adding one
+// entry to the list in transform_strategy.cpp
+const std::vector<StrategyRegistration> &get_strategy_registry();
+
+// returns nullptr when no strategy has that name
+std::unique_ptr<TransformStrategy> create_strategy(const std::string &name);
+
+#endif // TRANSFORM_STRATEGY_HPP
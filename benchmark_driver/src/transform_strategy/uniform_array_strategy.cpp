@@ -0,0 +1,93 @@
+#include "uniform_array_strategy.hpp"
+
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+
+#include "shader_utils/shader_utils.hpp"
+
+UniformArrayStrategy::~UniformArrayStrategy() {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteProgram(shader_program);
+}
+
+bool UniformArrayStrategy::initialize(const Scene &scene,
+                                      const StrategyOptions &options) {
+  num_objects = scene.num_objects;
+  model_matrices = scene.model_matrices.data();
+  if (options.dynamic_transforms) {
+    dynamic_model_matrices.assign(scene.model_matrices.begin(),
+                                  scene.model_matrices.end());
+    model_matrices = dynamic_model_matrices.data();
+  }
+
+  // every mat4 costs 16 components, keep a few matrices worth of room for
+  // projection, view and base_object
+  GLint max_vertex_uniform_components;
+  glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS,
+                &max_vertex_uniform_components);
+  int max_batch_size = max_vertex_uniform_components / 16 - 4;
+  if (max_batch_size <= 0) {
+    std::cerr << "uniform_array: GL_MAX_VERTEX_UNIFORM_COMPONENTS is too small"
+              << std::endl;
+    return false;
+  }
+  batch_size = std::min(num_objects, max_batch_size);
+
+  create_expanded_triangle_vao(num_objects, vao, vbo);
+
+  // gl_VertexID includes the first argument of glDrawArrays, so base_object
+  // maps it back into the current batch
+  std::string vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 position;\n"
+      "uniform mat4 projection;\n"
+      "uniform mat4 view;\n"
+      "uniform int base_object;\n"
+      "uniform mat4 modelMatrices[" +
+      std::to_string(batch_size) +
+      "];\n"
+      "void main() {\n"
+      "    int triangleIndex = gl_VertexID / 3 - base_object;\n"
+      "    gl_Position = projection * view * modelMatrices[triangleIndex] * "
+      "vec4(position, 1.0);\n"
+      "}\n";
+
+  shader_program = create_shader_program(vertex_shader_source.c_str(),
+                                         scene_fragment_shader_source);
+  if (shader_program == 0)
+    return false;
+
+  projection_location = glGetUniformLocation(shader_program, "projection");
+  view_location = glGetUniformLocation(shader_program, "view");
+  model_matrices_location =
+      glGetUniformLocation(shader_program, "modelMatrices");
+  base_object_location = glGetUniformLocation(shader_program, "base_object");
+  return true;
+}
+
+glm::mat4 *UniformArrayStrategy::begin_transform_update() {
+  return dynamic_model_matrices.data();
+}
+
+void UniformArrayStrategy::end_transform_update() {}
+
+void UniformArrayStrategy::draw(const FrameUniforms &uniforms) {
+  glUseProgram(shader_program);
+  glUniformMatrix4fv(projection_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.projection));
+  glUniformMatrix4fv(view_location, 1, GL_FALSE,
+                     glm::value_ptr(uniforms.view));
+
+  glBindVertexArray(vao);
+  for (int first = 0; first < num_objects; first += batch_size) {
+    int count = std::min(batch_size, num_objects - first);
+    glUniformMatrix4fv(model_matrices_location, count, GL_FALSE,
+                       glm::value_ptr(model_matrices[first]));
+    glUniform1i(base_object_location, first);
+    glDrawArrays(GL_TRIANGLES, 3 * first, 3 * count);
+  }
+  glBindVertexArray(0);
+}
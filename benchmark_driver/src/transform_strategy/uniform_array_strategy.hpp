@@ -0,0 +1,36 @@
+#ifndef UNIFORM_ARRAY_STRATEGY_HPP
+#define UNIFORM_ARRAY_STRATEGY_HPP
+
+#include <vector>
+
+#include "transform_strategy.hpp"
+
+// the transform_as_uniform_variable approach, every frame the model matrices
+// are uploaded with glUniformMatrix4fv into a default block mat4 array, since
+// that array is bounded by GL_MAX_VERTEX_UNIFORM_COMPONENTS the scene is drawn
+// in as many batches as it takes, with dynamic transforms the matrices are
+// written to client memory and the upload is part of draw
+class UniformArrayStrategy : public TransformStrategy {
+public:
+  ~UniformArrayStrategy() override;
+
+  bool initialize(const Scene &scene, const StrategyOptions &options) override;
+  glm::mat4 *begin_transform_update() override;
+  void end_transform_update() override;
+  void draw(const FrameUniforms &uniforms) override;
+  int get_draws_per_frame() const override {
+    return (num_objects + batch_size - 1) / batch_size;
+  }
+
+private:
+  int num_objects = 0;
+  int batch_size = 0;
+  const glm::mat4 *model_matrices = nullptr;
+  std::vector<glm::mat4> dynamic_model_matrices;
+
+  GLuint vao = 0, vbo = 0, shader_program = 0;
+  GLint projection_location = -1, view_location = -1;
+  GLint model_matrices_location = -1, base_object_location = -1;
+};
+
+#endif // UNIFORM_ARRAY_STRATEGY_HPP
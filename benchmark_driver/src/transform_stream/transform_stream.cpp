@@ -0,0 +1,236 @@
+#include "transform_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const std::array<std::pair<UploadMethod, const char *>, 5>
+    upload_method_names = {{
+        {UploadMethod::buffer_data, "buffer_data"},
+        {UploadMethod::buffer_sub_data, "buffer_sub_data"},
+        {UploadMethod::map_invalidate, "map_invalidate"},
+        {UploadMethod::map_unsynchronized, "map_unsynchronized"},
+        {UploadMethod::persistent_ring, "persistent_ring"},
+    }};
+
+bool parse_upload_method(const std::string &name, UploadMethod &method) {
+  for (const auto &[value, value_name] : upload_method_names) {
+    if (name == value_name) {
+      method = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *get_upload_method_name(UploadMethod method) {
+  for (const auto &[value, value_name] : upload_method_names)
+    if (value == method)
+      return value_name;
+  return "unknown";
+}
+
+TransformStream::TransformStream(GLenum target, UploadMethod method)
+    : target(target), method(method) {}
+
+TransformStream::~TransformStream() {
+  for (GLsync fence : fences)
+    if (fence != nullptr)
+      glDeleteSync(fence);
+  if (persistent_mapping != nullptr) {
+    glBindBuffer(target, buffer);
+    glUnmapBuffer(target);
+    glBindBuffer(target, 0);
+  }
+  glDeleteBuffers(1, &buffer);
+}
+
+bool TransformStream::is_ring() const {
+  return method == UploadMethod::map_unsynchronized ||
+         method == UploadMethod::persistent_ring;
+}
+
+bool TransformStream::initialize(GLsizeiptr frame_size,
+                                 const void *initial_data) {
+  this->frame_size = frame_size;
+
+  if (method == UploadMethod::persistent_ring && !GLAD_GL_VERSION_4_4) {
+    std::cerr << "persistent_ring: glBufferStorage needs OpenGL 4.4"
+              << std::endl;
+    return false;
+  }
+
+  // segments must start where any binding target may point, so align to the
+  // strictest of the offset alignments
+  GLint alignment = 16, uniform_alignment;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+  alignment = std::max(alignment, uniform_alignment);
+  if (GLAD_GL_VERSION_4_3) {
+    GLint storage_alignment;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,
+                  &storage_alignment);
+    alignment = std::max(alignment, storage_alignment);
+  }
+  segment_stride = (frame_size + alignment - 1) / alignment * alignment;
+
+  GLsizeiptr buffer_size =
+      is_ring() ? segment_stride * num_segments : frame_size;
+
+  glGenBuffers(1, &buffer);
+  glBindBuffer(target, buffer);
+  if (method == UploadMethod::persistent_ring) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, buffer_size, nullptr, flags);
+    persistent_mapping =
+        static_cast<char *>(glMapBufferRange(target, 0, buffer_size, flags));
+    if (persistent_mapping == nullptr) {
+      std::cerr << "persistent_ring: failed to map the buffer" << std::endl;
+      glBindBuffer(target, 0);
+      return false;
+    }
+  } else {
+    glBufferData(target, buffer_size, nullptr, GL_STREAM_DRAW);
+    if (method == UploadMethod::buffer_data ||
+        method == UploadMethod::buffer_sub_data)
+      staging.resize(frame_size);
+  }
+
+  if (initial_data != nullptr) {
+    for (int segment = 0; segment < (is_ring() ? num_segments : 1);
+         ++segment) {
+      if (persistent_mapping != nullptr)
+        std::memcpy(persistent_mapping + segment * segment_stride,
+                    initial_data, frame_size);
+      else
+        glBufferSubData(target, segment * segment_stride, frame_size,
+                        initial_data);
+    }
+  }
+  glBindBuffer(target, 0);
+  return true;
+}
+
+void *TransformStream::check_mapping(void *mapping) {
+  mapped = mapping != nullptr;
+  if (mapping == nullptr) {
+    GLenum error = glGetError();
+    std::cerr << get_upload_method_name(method)
+              << ": glMapBufferRange failed (GL error 0x" << std::hex << error
+              << std::dec << ")" << std::endl;
+    failed = true;
+  }
+  return mapping;
+}
+
+void *TransformStream::map() {
+  if (method == UploadMethod::map_invalidate) {
+    glBindBuffer(target, buffer);
+    return check_mapping(glMapBufferRange(
+        target, 0, frame_size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  }
+  if (!is_ring())
+    return staging.data();
+
+  // the previous segment has been drawn from by now, fence it so we know when
+  // it may be written again, then wait until the next one is free
+  fences[current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  current_segment = (current_segment + 1) % num_segments;
+
+  GLsync &fence = fences[current_segment];
+  if (fence != nullptr) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            1000000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  GLintptr offset = get_offset();
+  if (persistent_mapping != nullptr)
+    return persistent_mapping + offset;
+
+  glBindBuffer(target, buffer);
+  return check_mapping(glMapBufferRange(target, offset, frame_size,
+                                        GL_MAP_WRITE_BIT |
+                                            GL_MAP_UNSYNCHRONIZED_BIT |
+                                            GL_MAP_INVALIDATE_RANGE_BIT));
+}
+
+void TransformStream::unmap(GLsizeiptr used_size) {
+  switch (method) {
+  case UploadMethod::buffer_data:
+    glBindBuffer(target, buffer);
+    if (used_size == frame_size) {
+      glBufferData(target, frame_size, staging.data(), GL_STREAM_DRAW);
+    } else {
+      glBufferData(target, frame_size, nullptr, GL_STREAM_DRAW);
+      glBufferSubData(target, 0, used_size, staging.data());
+    }
+    break;
+  case UploadMethod::buffer_sub_data:
+    glBindBuffer(target, buffer);
+    glBufferSubData(target, 0, used_size, staging.data());
+    break;
+  case UploadMethod::map_invalidate:
+  case UploadMethod::map_unsynchronized:
+    glBindBuffer(target, buffer);
+    if (mapped)
+      glUnmapBuffer(target);
+    mapped = false;
+    break;
+  case UploadMethod::persistent_ring:
+    // coherent mapping, nothing to flush
+    return;
+  }
+  glBindBuffer(target, 0);
+}
+
+bool TransformStream::supports_range_updates() const {
+  return method == UploadMethod::buffer_sub_data ||
+         method == UploadMethod::map_invalidate;
+}
+
+void TransformStream::update_ranges(const void *frame,
+                                    std::span<const ByteRange> ranges) {
+  if (ranges.empty())
+    return;
+  const char *bytes = static_cast<const char *>(frame);
+  glBindBuffer(target, buffer);
+  if (method == UploadMethod::buffer_sub_data) {
+    for (const ByteRange &range : ranges)
+      glBufferSubData(target, range.offset, range.size, bytes + range.offset);
+  } else {
+    // no invalidation, the bytes between the ranges must survive
+    GLintptr first = ranges.front().offset;
+    GLsizeiptr size = ranges.back().offset + ranges.back().size - first;
+    char *mapping = static_cast<char *>(check_mapping(glMapBufferRange(
+        target, first, size, GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT)));
+    if (mapping != nullptr) {
+      for (const ByteRange &range : ranges) {
+        std::memcpy(mapping + (range.offset - first), bytes + range.offset,
+                    range.size);
+        glFlushMappedBufferRange(target, range.offset - first, range.size);
+      }
+      glUnmapBuffer(target);
+      mapped = false;
+    }
+  }
+  glBindBuffer(target, 0);
+}
+
+size_t TransformStream::update_object_ranges(const void *frame,
+                                             std::span<const DirtyRange> dirty,
+                                             size_t object_size) {
+  size_t uploaded = 0;
+  byte_ranges.clear();
+  for (const DirtyRange &range : dirty) {
+    byte_ranges.push_back(
+        {static_cast<GLintptr>(range.first * object_size),
+         static_cast<GLsizeiptr>(range.count * object_size)});
+    uploaded += range.count * object_size;
+  }
+  update_ranges(frame, byte_ranges);
+  return uploaded;
+}
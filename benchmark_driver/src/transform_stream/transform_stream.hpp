@@ -0,0 +1,109 @@
+#ifndef TRANSFORM_STREAM_HPP
+#define TRANSFORM_STREAM_HPP
+
+#include <glad/glad.h>
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "dirty_tracker/dirty_tracker.hpp"
+
+// the ways a frame's worth of transforms can reach a buffer object
+enum class UploadMethod {
+  // glBufferData with the new contents, the driver orphans the old storage
+  buffer_data,
+  // glBufferSubData into the same storage every frame
+  buffer_sub_data,
+  // glMapBufferRange with GL_MAP_INVALIDATE_BUFFER_BIT
+  map_invalidate,
+  // glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT into a three segment ring,
+  // fences keep the cpu from overwriting a segment the gpu still reads
+  map_unsynchronized,
+  // a three segment ring created with glBufferStorage and mapped once with
+  // GL_MAP_PERSISTENT_BIT, synchronized with fences (gl 4.4)
+  persistent_ring,
+};
+
+// size bytes starting at offset into a frame of a TransformStream
+struct ByteRange {
+  GLintptr offset = 0;
+  GLsizeiptr size = 0;
+};
+
+bool parse_upload_method(const std::string &name, UploadMethod &method);
+const char *get_upload_method_name(UploadMethod method);
+
+// a buffer object whose contents are replaced every frame, map returns the
+// memory to write the frame's data into and unmap makes it visible to the
+// following draws, ring methods move to a different segment every frame so
+// users must bind get_buffer at get_offset after each unmap
+class TransformStream {
+public:
+  TransformStream(GLenum target, UploadMethod method);
+  ~TransformStream();
+
+  TransformStream(const TransformStream &) = delete;
+  TransformStream &operator=(const TransformStream &) = delete;
+
+  // frame_size bytes are written per frame, initial_data (may be null) fills
+  // every segment, returns false and logs when the method is unsupported
+  bool initialize(GLsizeiptr frame_size, const void *initial_data);
+
+  // nullptr when the buffer could not be mapped, the gl error is logged and
+  // has_failed is set, unmap must still be called
+  void *map();
+  void unmap() { unmap(frame_size); }
+  // only the first used_size bytes of the frame were written, the copying
+  // methods upload just those, the rest of the frame is undefined afterwards
+  void unmap(GLsizeiptr used_size);
+
+  // whether update_ranges works, only the single segment methods that write
+  // in place can leave the rest of the buffer as it was: buffer_sub_data and
+  // map_invalidate
+  bool supports_range_updates() const;
+  // copies the given byte ranges of frame, the full frame_size image of the
+  // buffer, into the buffer and leaves the other bytes alone, instead of
+  // map and unmap: one glBufferSubData per range, or for map_invalidate the
+  // span of the ranges mapped once with GL_MAP_FLUSH_EXPLICIT_BIT and each
+  // range flushed on its own
+  void update_ranges(const void *frame, std::span<const ByteRange> ranges);
+  // update_ranges for frames holding objects of object_size bytes back to
+  // back, dirty counts objects, returns the bytes uploaded
+  size_t update_object_ranges(const void *frame,
+                              std::span<const DirtyRange> dirty,
+                              size_t object_size);
+
+  // whether a mapping failed, the buffer's contents are stale from then on
+  bool has_failed() const { return failed; }
+
+  GLuint get_buffer() const { return buffer; }
+  GLintptr get_offset() const { return current_segment * segment_stride; }
+  GLsizeiptr get_frame_size() const { return frame_size; }
+
+private:
+  static constexpr int num_segments = 3;
+
+  bool is_ring() const;
+  // logs and records a failed glMapBufferRange, returns mapping
+  void *check_mapping(void *mapping);
+
+  GLenum target;
+  UploadMethod method;
+  GLsizeiptr frame_size = 0;
+  GLsizeiptr segment_stride = 0;
+
+  GLuint buffer = 0;
+  int current_segment = 0;
+  bool mapped = false;
+  bool failed = false;
+  std::array<GLsync, num_segments> fences{};
+
+  // persistent_ring keeps the mapping for the buffer's lifetime,
+  // buffer_data and buffer_sub_data write into staging and copy from there
+  char *persistent_mapping = nullptr;
+  std::vector<char> staging;
+  std::vector<ByteRange> byte_ranges;
+};
+
+#endif // TRANSFORM_STREAM_HPP
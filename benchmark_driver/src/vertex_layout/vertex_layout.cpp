@@ -0,0 +1,253 @@
+#include "vertex_layout.hpp"
+
+#include <array>
+#include <cstddef>
+#include <glm/gtc/packing.hpp>
+#include <utility>
+
+static const std::array<std::pair<VertexLayout, const char *>, 4>
+    vertex_layout_names = {{
+        {VertexLayout::aos_float, "aos_float"},
+        {VertexLayout::soa_float, "soa_float"},
+        {VertexLayout::aos_half, "aos_half"},
+        {VertexLayout::aos_packed, "aos_packed"},
+    }};
+
+bool parse_vertex_layout(const std::string &name, VertexLayout &layout) {
+  for (const auto &[value, value_name] : vertex_layout_names) {
+    if (name == value_name) {
+      layout = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *get_vertex_layout_name(VertexLayout layout) {
+  for (const auto &[value, value_name] : vertex_layout_names)
+    if (value == layout)
+      return value_name;
+  return "unknown";
+}
+
+bool parse_index_type(const std::string &name, IndexType &type) {
+  if (name != "u16" && name != "u32")
+    return false;
+  type = name == "u16" ? IndexType::u16 : IndexType::u32;
+  return true;
+}
+
+const char *get_index_type_name(IndexType type) {
+  return type == IndexType::u16 ? "u16" : "u32";
+}
+
+GLenum get_index_gl_type(IndexType type) {
+  return type == IndexType::u16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool fits_index_type(size_t num_vertices, IndexType type) {
+  return type == IndexType::u32 || num_vertices <= 65536;
+}
+
+// the fourth position and normal components pad the attributes to 4 byte
+// offsets, attribute fetch is only required to handle aligned data
+struct HalfVertex {
+  uint16_t position[4];
+  uint16_t normal[4];
+  uint16_t uv[2];
+  uint16_t color[4];
+};
+static_assert(sizeof(HalfVertex) == 28);
+
+struct PackedVertex {
+  int16_t position[4];
+  uint32_t normal;
+  uint16_t uv[2];
+  uint32_t color;
+};
+static_assert(sizeof(PackedVertex) == 20);
+static_assert(sizeof(MeshVertex) == 48);
+
+GLsizei get_vertex_size(VertexLayout layout) {
+  switch (layout) {
+  case VertexLayout::aos_float:
+  case VertexLayout::soa_float:
+    return sizeof(MeshVertex);
+  case VertexLayout::aos_half:
+    return sizeof(HalfVertex);
+  case VertexLayout::aos_packed:
+    return sizeof(PackedVertex);
+  }
+  return sizeof(MeshVertex);
+}
+
+static HalfVertex encode_half(const MeshVertex &vertex) {
+  HalfVertex encoded;
+  for (int i = 0; i < 3; ++i) {
+    encoded.position[i] = glm::packHalf1x16(vertex.position[i]);
+    encoded.normal[i] = glm::packHalf1x16(vertex.normal[i]);
+  }
+  encoded.position[3] = glm::packHalf1x16(1.0f);
+  encoded.normal[3] = 0;
+  for (int i = 0; i < 2; ++i)
+    encoded.uv[i] = glm::packHalf1x16(vertex.uv[i]);
+  for (int i = 0; i < 4; ++i)
+    encoded.color[i] = glm::packHalf1x16(vertex.color[i]);
+  return encoded;
+}
+
+static PackedVertex encode_packed(const MeshVertex &vertex) {
+  PackedVertex encoded;
+  for (int i = 0; i < 3; ++i)
+    encoded.position[i] =
+        static_cast<int16_t>(glm::packSnorm1x16(vertex.position[i]));
+  encoded.position[3] = 0;
+  encoded.normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+  for (int i = 0; i < 2; ++i)
+    encoded.uv[i] = glm::packUnorm1x16(vertex.uv[i]);
+  encoded.color = glm::packUnorm4x8(vertex.color);
+  return encoded;
+}
+
+static GLuint create_buffer(GLenum target, const void *data, GLsizeiptr size) {
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(target, buffer);
+  glBufferData(target, size, data, GL_STATIC_DRAW);
+  return buffer;
+}
+
+// the attribute reads from the buffer bound to GL_ARRAY_BUFFER
+static void set_attribute(GLuint location, GLint size, GLenum type,
+                          GLboolean normalized, GLsizei stride,
+                          size_t offset) {
+  glVertexAttribPointer(location, size, type, normalized, stride,
+                        (GLvoid *)offset);
+  glEnableVertexAttribArray(location);
+}
+
+// one stream per attribute, each holding a member of every vertex
+template <typename Attribute>
+static GLuint create_stream(const std::vector<MeshVertex> &vertices,
+                            Attribute MeshVertex::*member) {
+  std::vector<Attribute> stream;
+  stream.reserve(vertices.size());
+  for (const MeshVertex &vertex : vertices)
+    stream.push_back(vertex.*member);
+  return create_buffer(GL_ARRAY_BUFFER, stream.data(),
+                       stream.size() * sizeof(Attribute));
+}
+
+template <typename Vertex, typename Encode>
+static GLuint create_interleaved(const std::vector<MeshVertex> &vertices,
+                                 Encode encode) {
+  std::vector<Vertex> encoded;
+  encoded.reserve(vertices.size());
+  for (const MeshVertex &vertex : vertices)
+    encoded.push_back(encode(vertex));
+  return create_buffer(GL_ARRAY_BUFFER, encoded.data(),
+                       encoded.size() * sizeof(Vertex));
+}
+
+GLuint create_index_buffer(std::span<const uint32_t> indices, IndexType type,
+                           GLsizeiptr &size) {
+  if (type == IndexType::u32) {
+    size = indices.size() * sizeof(uint32_t);
+    return create_buffer(GL_ELEMENT_ARRAY_BUFFER, indices.data(), size);
+  }
+  std::vector<uint16_t> narrowed(indices.begin(), indices.end());
+  size = narrowed.size() * sizeof(uint16_t);
+  return create_buffer(GL_ELEMENT_ARRAY_BUFFER, narrowed.data(), size);
+}
+
+void create_mesh_buffers(const Mesh &mesh, VertexLayout layout, bool indexed,
+                         IndexType index_type, MeshBuffers &buffers) {
+  std::vector<MeshVertex> expanded;
+  if (!indexed) {
+    expanded.reserve(mesh.indices.size());
+    for (uint32_t index : mesh.indices)
+      expanded.push_back(mesh.vertices[index]);
+  }
+  const std::vector<MeshVertex> &vertices = indexed ? mesh.vertices : expanded;
+
+  switch (layout) {
+  case VertexLayout::aos_float: {
+    GLsizei stride = sizeof(MeshVertex);
+    buffers.vertex_buffers.push_back(
+        create_buffer(GL_ARRAY_BUFFER, vertices.data(),
+                      vertices.size() * sizeof(MeshVertex)));
+    set_attribute(0, 3, GL_FLOAT, GL_FALSE, stride,
+                  offsetof(MeshVertex, position));
+    set_attribute(1, 3, GL_FLOAT, GL_FALSE, stride,
+                  offsetof(MeshVertex, normal));
+    set_attribute(2, 2, GL_FLOAT, GL_FALSE, stride, offsetof(MeshVertex, uv));
+    set_attribute(3, 4, GL_FLOAT, GL_FALSE, stride,
+                  offsetof(MeshVertex, color));
+    break;
+  }
+  case VertexLayout::soa_float:
+    buffers.vertex_buffers.push_back(
+        create_stream(vertices, &MeshVertex::position));
+    set_attribute(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    buffers.vertex_buffers.push_back(
+        create_stream(vertices, &MeshVertex::normal));
+    set_attribute(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    buffers.vertex_buffers.push_back(create_stream(vertices, &MeshVertex::uv));
+    set_attribute(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    buffers.vertex_buffers.push_back(
+        create_stream(vertices, &MeshVertex::color));
+    set_attribute(3, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    break;
+  case VertexLayout::aos_half: {
+    GLsizei stride = sizeof(HalfVertex);
+    buffers.vertex_buffers.push_back(
+        create_interleaved<HalfVertex>(vertices, encode_half));
+    set_attribute(0, 3, GL_HALF_FLOAT, GL_FALSE, stride,
+                  offsetof(HalfVertex, position));
+    set_attribute(1, 3, GL_HALF_FLOAT, GL_FALSE, stride,
+                  offsetof(HalfVertex, normal));
+    set_attribute(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                  offsetof(HalfVertex, uv));
+    set_attribute(3, 4, GL_HALF_FLOAT, GL_FALSE, stride,
+                  offsetof(HalfVertex, color));
+    break;
+  }
+  case VertexLayout::aos_packed: {
+    GLsizei stride = sizeof(PackedVertex);
+    buffers.vertex_buffers.push_back(
+        create_interleaved<PackedVertex>(vertices, encode_packed));
+    set_attribute(0, 3, GL_SHORT, GL_TRUE, stride,
+                  offsetof(PackedVertex, position));
+    // packed formats always have 4 components, w is ignored by the vec3 input
+    set_attribute(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                  offsetof(PackedVertex, normal));
+    set_attribute(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                  offsetof(PackedVertex, uv));
+    set_attribute(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                  offsetof(PackedVertex, color));
+    break;
+  }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  buffers.size = static_cast<GLsizeiptr>(vertices.size()) *
+                 get_vertex_size(layout);
+
+  if (indexed) {
+    GLsizeiptr index_size;
+    // the element array binding is vao state, left bound on purpose
+    buffers.index_buffer =
+        create_index_buffer(mesh.indices, index_type, index_size);
+    buffers.index_type = get_index_gl_type(index_type);
+    buffers.size += index_size;
+    buffers.count = static_cast<GLsizei>(mesh.indices.size());
+  } else {
+    buffers.count = static_cast<GLsizei>(vertices.size());
+  }
+}
+
+void delete_mesh_buffers(MeshBuffers &buffers) {
+  glDeleteBuffers(buffers.vertex_buffers.size(),
+                  buffers.vertex_buffers.data());
+  glDeleteBuffers(1, &buffers.index_buffer);
+  buffers = MeshBuffers();
+}
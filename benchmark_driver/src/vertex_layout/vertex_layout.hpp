@@ -0,0 +1,77 @@
+#ifndef VERTEX_LAYOUT_HPP
+#define VERTEX_LAYOUT_HPP
+
+#include <glad/glad.h>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../mesh/mesh.hpp"
+
+// how a mesh's position, normal, uv and color reach the vertex shader, every
+// layout feeds the same vec3 / vec3 / vec2 / vec4 inputs so one shader draws
+// them all
+enum class VertexLayout {
+  // every attribute as floats interleaved in one buffer, 48 bytes
+  aos_float,
+  // the same floats with one tightly packed buffer per attribute
+  soa_float,
+  // every attribute as GL_HALF_FLOAT, interleaved, 28 bytes
+  aos_half,
+  // normalized shorts for the position and uv, a GL_INT_2_10_10_10_REV
+  // normal and an 8 bit unorm color, interleaved, 20 bytes
+  aos_packed,
+};
+
+bool parse_vertex_layout(const std::string &name, VertexLayout &layout);
+const char *get_vertex_layout_name(VertexLayout layout);
+
+// bytes one vertex takes up across all of its buffers
+GLsizei get_vertex_size(VertexLayout layout);
+
+// how indexed meshes store their indices, 16 bit indices halve the index
+// buffer and its fetch but only address 65536 vertices
+enum class IndexType {
+  u16,
+  u32,
+};
+
+bool parse_index_type(const std::string &name, IndexType &type);
+const char *get_index_type_name(IndexType type);
+
+// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, for glDrawElements*
+GLenum get_index_gl_type(IndexType type);
+
+// whether indices of the type can address num_vertices vertices
+bool fits_index_type(size_t num_vertices, IndexType type);
+
+// writes the indices as the given type, which must fit them, into a new
+// buffer left bound to GL_ELEMENT_ARRAY_BUFFER and with it to the bound vao,
+// size is set to the bytes it holds
+GLuint create_index_buffer(std::span<const uint32_t> indices, IndexType type,
+                           GLsizeiptr &size);
+
+// the gl objects holding one mesh in one layout
+struct MeshBuffers {
+  // one per attribute stream
+  std::vector<GLuint> vertex_buffers;
+  // 0 for non indexed meshes
+  GLuint index_buffer = 0;
+  // indices for glDrawElements*, vertices for glDrawArrays*
+  GLsizei count = 0;
+  // the type argument of glDrawElements*
+  GLenum index_type = GL_UNSIGNED_INT;
+  // vertex and index data together
+  GLsizeiptr size = 0;
+};
+
+// writes the mesh into new buffers in the given layout and points attributes
+// 0 (position), 1 (normal), 2 (uv) and 3 (color) of the bound vao at them,
+// indexed meshes also bind their index buffer of index_type to the vao, which
+// must fit the mesh, otherwise every triangle is expanded into three vertices
+// of its own
+void create_mesh_buffers(const Mesh &mesh, VertexLayout layout, bool indexed,
+                         IndexType index_type, MeshBuffers &buffers);
+void delete_mesh_buffers(MeshBuffers &buffers);
+
+#endif // VERTEX_LAYOUT_HPP
@@ -0,0 +1,18 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+void Arena::AlignedDeleter::operator()(std::byte *memory) const {
+  std::free(memory);
+}
+
+Arena::Arena(size_t capacity)
+    : capacity((capacity + alignment - 1) / alignment * alignment) {
+  // pages are only touched when the arrays are first written, so parallel
+  // generation also spreads them across memory nodes
+  memory.reset(static_cast<std::byte *>(std::aligned_alloc(
+      alignment, std::max<size_t>(this->capacity, alignment))));
+  if (!memory)
+    throw std::bad_alloc();
+}
@@ -0,0 +1,55 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+// one aligned allocation made up front and handed out as arrays, nothing is
+// released individually, everything goes with the arena, meant for scene data
+// whose size is known from the object count before anything is generated
+class Arena {
+public:
+  // every array starts on a cache line, which also satisfies any simd load
+  static constexpr size_t alignment = 64;
+
+  explicit Arena(size_t capacity);
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // bytes an array of count elements takes up in an arena, use the sum over
+  // all arrays to size the arena
+  template <typename T> static constexpr size_t footprint(size_t count) {
+    return (count * sizeof(T) + alignment - 1) / alignment * alignment;
+  }
+
+  // the elements are left uninitialized, throws std::bad_alloc when the
+  // arena was sized too small
+  template <typename T> std::span<T> allocate(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena memory is never destroyed element by element");
+    size_t size = footprint<T>(count);
+    if (size > capacity - used)
+      throw std::bad_alloc();
+    T *first = reinterpret_cast<T *>(memory.get() + used);
+    used += size;
+    return std::span<T>(first, count);
+  }
+
+  size_t get_capacity() const { return capacity; }
+  size_t get_used() const { return used; }
+
+private:
+  struct AlignedDeleter {
+    void operator()(std::byte *memory) const;
+  };
+
+  std::unique_ptr<std::byte[], AlignedDeleter> memory;
+  size_t capacity;
+  size_t used = 0;
+};
+
+#endif // ARENA_HPP
@@ -0,0 +1,63 @@
+#include "dirty_tracker.hpp"
+
+#include <algorithm>
+#include <bit>
+
+DirtyTracker::DirtyTracker(size_t num_objects) { resize(num_objects); }
+
+void DirtyTracker::resize(size_t num_objects) {
+  this->num_objects = num_objects;
+  size_t num_blocks = (num_objects + 63) / 64;
+  object_bits.assign(num_blocks, 0);
+  block_bits.assign((num_blocks + 63) / 64, 0);
+}
+
+bool DirtyTracker::any() const {
+  return std::any_of(block_bits.begin(), block_bits.end(),
+                     [](uint64_t bits) { return bits != 0; });
+}
+
+void DirtyTracker::collect_ranges(std::vector<DirtyRange> &ranges,
+                                  size_t max_gap) const {
+  // runs of set bits are extended while the next one starts close enough,
+  // which also joins runs that continue across a block boundary
+  bool open = false;
+  size_t run_first = 0, run_end = 0;
+  auto add_run = [&](size_t first, size_t end) {
+    if (open && first - run_end <= max_gap) {
+      run_end = end;
+      return;
+    }
+    if (open)
+      ranges.push_back({run_first, run_end - run_first});
+    open = true;
+    run_first = first;
+    run_end = end;
+  };
+
+  for (size_t word = 0; word < block_bits.size(); ++word) {
+    for (uint64_t blocks = block_bits[word]; blocks != 0;
+         blocks &= blocks - 1) {
+      size_t block = word * 64 + std::countr_zero(blocks);
+      uint64_t bits = object_bits[block];
+      while (bits != 0) {
+        int start = std::countr_zero(bits);
+        int length = std::countr_one(bits >> start);
+        add_run(block * 64 + start, block * 64 + start + length);
+        bits = start + length < 64 ? bits & (~uint64_t(0) << (start + length))
+                                   : 0;
+      }
+    }
+  }
+  if (open)
+    ranges.push_back({run_first, run_end - run_first});
+}
+
+void DirtyTracker::clear() {
+  for (size_t word = 0; word < block_bits.size(); ++word) {
+    for (uint64_t blocks = block_bits[word]; blocks != 0;
+         blocks &= blocks - 1)
+      object_bits[word * 64 + std::countr_zero(blocks)] = 0;
+    block_bits[word] = 0;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef DIRTY_TRACKER_HPP
+#define DIRTY_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// count objects starting at first
+struct DirtyRange {
+  size_t first = 0;
+  size_t count = 0;
+};
+
+// which of a fixed number of objects changed since the last clear, one bit
+// per object in blocks of 64 plus one bit per block, so that collecting and
+// clearing the changes costs time in the number of dirty blocks rather than
+// the number of objects
+class DirtyTracker {
+public:
+  explicit DirtyTracker(size_t num_objects = 0);
+
+  // every object starts out clean
+  void resize(size_t num_objects);
+  size_t size() const { return num_objects; }
+
+  void mark(size_t index) {
+    object_bits[index / 64] |= uint64_t(1) << (index % 64);
+    block_bits[index / 4096] |= uint64_t(1) << (index / 64 % 64);
+  }
+  bool any() const;
+
+  // appends the dirty objects to ranges in ascending order, ranges separated
+  // by at most max_gap clean objects are merged since uploading a few
+  // unchanged objects costs less than another upload call
+  void collect_ranges(std::vector<DirtyRange> &ranges,
+                      size_t max_gap = 0) const;
+
+  void clear();
+
+private:
+  size_t num_objects = 0;
+  std::vector<uint64_t> object_bits;
+  std::vector<uint64_t> block_bits;
+};
+
+#endif // DIRTY_TRACKER_HPP
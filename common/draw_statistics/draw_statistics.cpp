@@ -0,0 +1,91 @@
+#include "draw_statistics.hpp"
+
+#include "gl_extensions/gl_extensions.hpp"
+
+DrawStatistics::DrawStatistics() {
+  // GL_TIMESTAMP is core since 3.3 like GL_TIME_ELAPSED
+  timestamps =
+      GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3);
+  pipeline_statistics = GLAD_GL_VERSION_4_6 ||
+                        has_gl_extension("GL_ARB_pipeline_statistics_query");
+
+  counters = {{GL_PRIMITIVES_GENERATED, "primitives_generated"},
+              {GL_SAMPLES_PASSED, "samples_passed"}};
+  // the core 4.6 enums have the same values as the extension's _ARB ones
+  if (pipeline_statistics) {
+    counters.push_back({GL_VERTEX_SHADER_INVOCATIONS,
+                        "vertex_shader_invocations"});
+    counters.push_back({GL_CLIPPING_INPUT_PRIMITIVES,
+                        "clipping_input_primitives"});
+    counters.push_back({GL_CLIPPING_OUTPUT_PRIMITIVES,
+                        "clipping_output_primitives"});
+    counters.push_back({GL_FRAGMENT_SHADER_INVOCATIONS,
+                        "fragment_shader_invocations"});
+  }
+
+  for (QuerySet &set : query_sets) {
+    if (timestamps) {
+      glGenQueries(1, &set.start_timestamp);
+      glGenQueries(1, &set.end_timestamp);
+    }
+    set.counters.resize(counters.size());
+    glGenQueries(set.counters.size(), set.counters.data());
+  }
+}
+
+static bool is_available(GLuint query) {
+  GLuint available = GL_FALSE;
+  glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+  return available == GL_TRUE;
+}
+
+void DrawStatistics::collect(QuerySet &set, FrameTimer &frame_timer) {
+  set.pending = false;
+  if (timestamps && !is_available(set.end_timestamp))
+    return;
+  for (GLuint query : set.counters)
+    if (!is_available(query))
+      return;
+
+  if (timestamps) {
+    GLuint64 start_ns = 0, end_ns = 0;
+    glGetQueryObjectui64v(set.start_timestamp, GL_QUERY_RESULT, &start_ns);
+    glGetQueryObjectui64v(set.end_timestamp, GL_QUERY_RESULT, &end_ns);
+    frame_timer.record("draw_gpu_ms", (end_ns - start_ns) / 1.0e6);
+  }
+  for (size_t i = 0; i < counters.size(); ++i) {
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(set.counters[i], GL_QUERY_RESULT, &value);
+    frame_timer.record(counters[i].metric, static_cast<double>(value));
+  }
+}
+
+void DrawStatistics::begin(FrameTimer &frame_timer) {
+  QuerySet &set = query_sets[frame_index % num_query_sets];
+  if (set.pending)
+    collect(set, frame_timer);
+
+  if (timestamps)
+    glQueryCounter(set.start_timestamp, GL_TIMESTAMP);
+  for (size_t i = 0; i < counters.size(); ++i)
+    glBeginQuery(counters[i].target, set.counters[i]);
+}
+
+void DrawStatistics::end() {
+  QuerySet &set = query_sets[frame_index % num_query_sets];
+  for (const Counter &counter : counters)
+    glEndQuery(counter.target);
+  if (timestamps)
+    glQueryCounter(set.end_timestamp, GL_TIMESTAMP);
+  set.pending = true;
+  ++frame_index;
+}
+
+void DrawStatistics::finish() {
+  for (QuerySet &set : query_sets) {
+    glDeleteQueries(1, &set.start_timestamp);
+    glDeleteQueries(1, &set.end_timestamp);
+    glDeleteQueries(set.counters.size(), set.counters.data());
+    set = QuerySet();
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef DRAW_STATISTICS_HPP
+#define DRAW_STATISTICS_HPP
+
+#include <glad/glad.h>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "frame_timer/frame_timer.hpp"
+
+// gpu counters for the draws between begin and end: the gpu time they took
+// (a pair of GL_TIMESTAMP queries, since the frame's GL_TIME_ELAPSED query is
+// already active), GL_PRIMITIVES_GENERATED, GL_SAMPLES_PASSED and, with gl 4.6
+// or ARB_pipeline_statistics_query, vertex and fragment shader invocations and
+// clipping input and output primitives, the queries are double buffered and
+// read back when their set comes around again two frames later, a result that
+// is still not available then is dropped rather than waited for
+class DrawStatistics {
+public:
+  // must be constructed with the context current
+  DrawStatistics();
+
+  DrawStatistics(const DrawStatistics &) = delete;
+  DrawStatistics &operator=(const DrawStatistics &) = delete;
+
+  bool has_pipeline_statistics() const { return pipeline_statistics; }
+
+  // records the results of the draws measured two frames ago into
+  // frame_timer, then starts measuring
+  void begin(FrameTimer &frame_timer);
+  void end();
+
+  // releases the queries, call once after the last frame while the context is
+  // still current
+  void finish();
+
+private:
+  static constexpr size_t num_query_sets = 2;
+
+  struct Counter {
+    GLenum target;
+    // frame timer metric the result is recorded as
+    std::string metric;
+  };
+
+  struct QuerySet {
+    GLuint start_timestamp = 0;
+    GLuint end_timestamp = 0;
+    // one per counter
+    std::vector<GLuint> counters;
+    bool pending = false;
+  };
+
+  void collect(QuerySet &set, FrameTimer &frame_timer);
+
+  bool timestamps = false;
+  bool pipeline_statistics = false;
+  std::vector<Counter> counters;
+  std::array<QuerySet, num_query_sets> query_sets;
+  size_t frame_index = 0;
+};
+
+#endif // DRAW_STATISTICS_HPP
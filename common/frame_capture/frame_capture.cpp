@@ -0,0 +1,202 @@
+#include "frame_capture.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#include "ppm_image/ppm_image.hpp"
+
+bool parse_frame_capture_options(int &argc, char *argv[],
+                                 FrameCaptureOptions &options) {
+  int write_index = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--fixed-timestep") {
+      options.fixed_timestep = true;
+    } else if (arg == "--capture" || arg == "--capture-every") {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: " << arg << " requires a value.\n";
+        return false;
+      }
+      if (arg == "--capture") {
+        options.directory = argv[++i];
+        // frames are only comparable across runs when they show the same
+        // moment
+        options.fixed_timestep = true;
+      } else {
+        options.interval = std::atoi(argv[++i]);
+        if (options.interval <= 0) {
+          std::cerr << "Error: --capture-every must be a positive integer.\n";
+          return false;
+        }
+      }
+    } else {
+      argv[write_index++] = argv[i];
+    }
+  }
+  argc = write_index;
+  argv[argc] = nullptr;
+  return true;
+}
+
+FrameCapture::FrameCapture(const FrameCaptureOptions &options, int width,
+                           int height)
+    : options(options), width(width), height(height) {}
+
+FrameCapture::~FrameCapture() {
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    image_available.notify_all();
+    writer.join();
+  }
+  for (Readback &readback : readbacks) {
+    if (readback.fence != nullptr)
+      glDeleteSync(readback.fence);
+    glDeleteBuffers(1, &readback.buffer);
+  }
+}
+
+bool FrameCapture::initialize() {
+  std::error_code error;
+  std::filesystem::create_directories(options.directory, error);
+  if (error) {
+    std::cerr << "Failed to create capture directory " << options.directory
+              << ": " << error.message() << std::endl;
+    return false;
+  }
+
+  GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+  for (Readback &readback : readbacks) {
+    glGenBuffers(1, &readback.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  writer = std::thread(&FrameCapture::writer_loop, this);
+  return true;
+}
+
+void FrameCapture::capture(int frame) {
+  // oldest first, a readback whose fence has not signalled yet is left for a
+  // later frame
+  for (size_t i = 0; i < num_buffers; ++i) {
+    Readback &readback = readbacks[(next_readback + i) % num_buffers];
+    if (readback.fence == nullptr)
+      continue;
+    GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+      collect(readback);
+  }
+
+  if (frame % options.interval != 0)
+    return;
+
+  Readback &readback = readbacks[next_readback];
+  next_readback = (next_readback + 1) % num_buffers;
+  if (readback.fence != nullptr) {
+    glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                     GL_TIMEOUT_IGNORED);
+    collect(readback);
+    ++stalls;
+  }
+
+  // rgba bytes is the format implementations read back without converting
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  readback.frame = frame;
+  ++frames_captured;
+}
+
+void FrameCapture::collect(Readback &readback) {
+  PendingImage image;
+  image.frame = readback.frame;
+  image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                        image.pixels.size(), GL_MAP_READ_BIT);
+  if (pixels != nullptr) {
+    std::memcpy(image.pixels.data(), pixels, image.pixels.size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    std::cerr << "Failed to map the readback of frame " << readback.frame
+              << std::endl;
+    image.pixels.clear();
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glDeleteSync(readback.fence);
+  readback.fence = nullptr;
+
+  if (image.pixels.empty())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    images.push_back(std::move(image));
+  }
+  image_available.notify_one();
+}
+
+void FrameCapture::writer_loop() {
+  while (true) {
+    PendingImage pending;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      image_available.wait(lock, [&] { return stopping || !images.empty(); });
+      if (images.empty())
+        break;
+      pending = std::move(images.front());
+      images.pop_front();
+    }
+
+    // gl rows start at the bottom
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+      const uint8_t *source = pending.pixels.data() +
+                              static_cast<size_t>(height - 1 - y) * width * 4;
+      uint8_t *destination =
+          image.pixels.data() + static_cast<size_t>(y) * width * 3;
+      for (int x = 0; x < width; ++x) {
+        destination[x * 3] = source[x * 4];
+        destination[x * 3 + 1] = source[x * 4 + 1];
+        destination[x * 3 + 2] = source[x * 4 + 2];
+      }
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06d.ppm", pending.frame);
+    write_ppm((std::filesystem::path(options.directory) / name).string(),
+              image);
+  }
+}
+
+void FrameCapture::finish() {
+  for (size_t i = 0; i < num_buffers; ++i) {
+    Readback &readback = readbacks[(next_readback + i) % num_buffers];
+    if (readback.fence == nullptr)
+      continue;
+    glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                     GL_TIMEOUT_IGNORED);
+    collect(readback);
+  }
+  // the writer drains the queue before it stops
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    image_available.notify_all();
+    writer.join();
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <glad/glad.h>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FrameCaptureOptions {
+  // captured frames are written here as frame_<index>.ppm when set
+  std::string directory;
+  // every this many frames, starting with frame 0
+  int interval = 60;
+  // windowed runs take the animation clock from the frame index, 1/60 s per
+  // frame, like headless runs always do, capturing turns it on
+  bool fixed_timestep = false;
+};
+
+// consumes --capture <dir>, --capture-every <frames> and --fixed-timestep
+// from argv, same contract as parse_headless_options
+bool parse_frame_capture_options(int &argc, char *argv[],
+                                 FrameCaptureOptions &options);
+
+// reads frames back without stalling the render loop: a due frame is copied
+// into the next of a small ring of pixel pack buffers by an asynchronous
+// glReadPixels and fenced, later frames map the buffers whose fence has
+// signalled and hand the pixels to a writer thread that converts and writes
+// them, the render loop only waits when every buffer is still in flight
+class FrameCapture {
+public:
+  // reads width x height pixels from the framebuffer bound for reading, must
+  // be constructed with the context current
+  FrameCapture(const FrameCaptureOptions &options, int width, int height);
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  // creates the directory and the buffers and starts the writer, returns
+  // false and logs the reason on failure
+  bool initialize();
+
+  // call every frame after drawing and before presenting
+  void capture(int frame);
+
+  // waits for every readback and write still pending, call once after the
+  // last frame while the context is still current
+  void finish();
+
+  int get_frames_captured() const { return frames_captured; }
+  // captures that had to wait for the oldest readback to finish
+  int get_stalls() const { return stalls; }
+
+private:
+  static constexpr size_t num_buffers = 3;
+
+  struct Readback {
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    int frame = 0;
+  };
+
+  struct PendingImage {
+    int frame = 0;
+    // rgba, rows bottom to top as read
+    std::vector<uint8_t> pixels;
+  };
+
+  // maps the finished readback and queues its pixels for the writer
+  void collect(Readback &readback);
+  void writer_loop();
+
+  FrameCaptureOptions options;
+  int width;
+  int height;
+  std::array<Readback, num_buffers> readbacks{};
+  size_t next_readback = 0;
+  int frames_captured = 0;
+  int stalls = 0;
+
+  std::thread writer;
+  std::deque<PendingImage> images;
+  std::mutex mutex;
+  std::condition_variable image_available;
+  bool stopping = false;
+};
+
+#endif // FRAME_CAPTURE_HPP
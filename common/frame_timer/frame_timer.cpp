@@ -0,0 +1,324 @@
+#include "frame_timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+bool parse_frame_timer_options(int &argc, char *argv[],
+                               FrameTimerOptions &options) {
+  int write_index = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--warmup" || arg == "--output") {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: " << arg << " requires a value.\n";
+        return false;
+      }
+      if (arg == "--output") {
+        options.output_path = argv[++i];
+        continue;
+      }
+      options.warmup_frames = std::atoi(argv[++i]);
+      if (options.warmup_frames < 0) {
+        std::cerr << "Error: --warmup must not be negative.\n";
+        return false;
+      }
+    } else if (arg == "--draw-stats") {
+      options.draw_statistics = true;
+    } else {
+      argv[write_index++] = argv[i];
+    }
+  }
+  argc = write_index;
+  argv[argc] = nullptr;
+  return true;
+}
+
+void clamp_warmup_frames(FrameTimerOptions &options, int num_frames) {
+  if (options.warmup_frames < num_frames)
+    return;
+  int warmup_frames = num_frames / 2;
+  std::cerr << "Warning: " << options.warmup_frames
+            << " warmup frames leave none of the " << num_frames
+            << " frames measured, warming up for " << warmup_frames
+            << " instead.\n";
+  options.warmup_frames = warmup_frames;
+}
+
+// linear interpolation between the two closest ranks, samples must be sorted
+static double percentile(const std::vector<double> &sorted_samples,
+                         double fraction) {
+  double rank = fraction * (sorted_samples.size() - 1);
+  size_t lower = static_cast<size_t>(std::floor(rank));
+  size_t upper = std::min(lower + 1, sorted_samples.size() - 1);
+  double weight = rank - lower;
+  return sorted_samples[lower] * (1.0 - weight) + sorted_samples[upper] * weight;
+}
+
+SampleSummary summarize(std::vector<double> samples) {
+  samples.erase(std::remove_if(samples.begin(), samples.end(),
+                               [](double s) { return std::isnan(s); }),
+                samples.end());
+
+  SampleSummary summary;
+  summary.count = samples.size();
+  if (samples.empty())
+    return summary;
+
+  std::sort(samples.begin(), samples.end());
+
+  double sum = 0.0;
+  for (double sample : samples)
+    sum += sample;
+  summary.mean = sum / samples.size();
+
+  double squared_deviations = 0.0;
+  for (double sample : samples)
+    squared_deviations += (sample - summary.mean) * (sample - summary.mean);
+  summary.standard_deviation = std::sqrt(squared_deviations / samples.size());
+
+  summary.min = samples.front();
+  summary.max = samples.back();
+  summary.p50 = percentile(samples, 0.50);
+  summary.p95 = percentile(samples, 0.95);
+  summary.p99 = percentile(samples, 0.99);
+  return summary;
+}
+
+FrameTimer::FrameTimer(int warmup_frames) : warmup_frames(warmup_frames) {
+  query_frame_indices.fill(-1);
+
+  // GL_TIME_ELAPSED is core since 3.3, older contexts need ARB_timer_query
+  gpu_timing_supported =
+      GLVersion.major > 3 || (GLVersion.major == 3 && GLVersion.minor >= 3);
+  if (gpu_timing_supported)
+    glGenQueries(num_queries_in_flight, queries.data());
+}
+
+void FrameTimer::collect_query(size_t slot) {
+  int measured_frame = query_frame_indices[slot];
+  query_frame_indices[slot] = -1;
+
+  // by the time a slot comes around again its result is almost always ready,
+  // if not this blocks until it is
+  GLuint64 elapsed_ns = 0;
+  glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+
+  if (measured_frame >= warmup_frames)
+    gpu_frame_times[measured_frame - warmup_frames] = elapsed_ns / 1.0e6;
+}
+
+void FrameTimer::begin_frame() {
+  if (gpu_timing_supported) {
+    size_t slot = frame_index % num_queries_in_flight;
+    if (query_frame_indices[slot] != -1)
+      collect_query(slot);
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    query_frame_indices[slot] = frame_index;
+  }
+  frame_start_time = std::chrono::steady_clock::now();
+}
+
+void FrameTimer::end_frame() {
+  std::chrono::duration<double, std::milli> cpu_time =
+      std::chrono::steady_clock::now() - frame_start_time;
+
+  if (gpu_timing_supported)
+    glEndQuery(GL_TIME_ELAPSED);
+
+  if (frame_index >= warmup_frames) {
+    cpu_frame_times.push_back(cpu_time.count());
+    gpu_frame_times.push_back(std::numeric_limits<double>::quiet_NaN());
+  }
+  ++frame_index;
+}
+
+void FrameTimer::record(const std::string &metric, double value) {
+  if (frame_index < warmup_frames)
+    return;
+
+  auto it = std::find_if(metrics.begin(), metrics.end(),
+                         [&](const Metric &m) { return m.name == metric; });
+  if (it == metrics.end()) {
+    metrics.push_back({metric, {}});
+    it = metrics.end() - 1;
+  }
+  // cpu_frame_times does not yet hold the current frame
+  it->values.resize(cpu_frame_times.size() + 1,
+                    std::numeric_limits<double>::quiet_NaN());
+  it->values.back() = value;
+}
+
+void FrameTimer::set_run_value(const std::string &name, double value) {
+  auto it = std::find_if(run_values.begin(), run_values.end(),
+                         [&](const RunValue &v) { return v.name == name; });
+  if (it == run_values.end())
+    run_values.push_back({name, value});
+  else
+    it->value = value;
+}
+
+std::vector<FrameTimer::Metric> FrameTimer::get_metrics() const {
+  std::vector<Metric> padded = metrics;
+  for (Metric &metric : padded)
+    metric.values.resize(cpu_frame_times.size(),
+                         std::numeric_limits<double>::quiet_NaN());
+  return padded;
+}
+
+void FrameTimer::finish() {
+  if (!gpu_timing_supported || queries[0] == 0)
+    return;
+  for (size_t slot = 0; slot < num_queries_in_flight; ++slot)
+    if (query_frame_indices[slot] != -1)
+      collect_query(slot);
+  glDeleteQueries(num_queries_in_flight, queries.data());
+  queries.fill(0);
+}
+
+static void print_summary_row(std::ostream &out, const std::string &label,
+                              const SampleSummary &summary) {
+  out << "  " << label << " min " << summary.min << " mean " << summary.mean
+      << " p50 " << summary.p50 << " p95 " << summary.p95 << " p99 "
+      << summary.p99 << " max " << summary.max << " stddev "
+      << summary.standard_deviation << '\n';
+}
+
+void FrameTimer::print_summary(std::ostream &out,
+                               const std::string &run_name) const {
+  std::ios_base::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(3);
+  out << run_name << ": " << cpu_frame_times.size() << " frames ("
+      << warmup_frames << " warmup frames discarded)\n";
+  print_summary_row(out, "cpu_ms", summarize(cpu_frame_times));
+  if (gpu_timing_supported)
+    print_summary_row(out, "gpu_ms", summarize(gpu_frame_times));
+  else
+    out << "  gpu timing unavailable\n";
+  for (const Metric &metric : metrics)
+    print_summary_row(out, metric.name, summarize(metric.values));
+  for (const RunValue &run_value : run_values)
+    out << "  " << run_value.name << ' ' << run_value.value << '\n';
+  out.flags(flags);
+}
+
+void write_json_summary(std::ostream &out, const SampleSummary &summary) {
+  out << "{\"count\": " << summary.count << ", \"min\": " << summary.min
+      << ", \"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+      << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+      << ", \"max\": " << summary.max
+      << ", \"stddev\": " << summary.standard_deviation << "}";
+}
+
+// json has no nan, missing gpu samples become null
+static void write_json_number(std::ostream &out, double value) {
+  if (std::isnan(value))
+    out << "null";
+  else
+    out << value;
+}
+
+static std::string gl_string(GLenum name) {
+  const GLubyte *value = glGetString(name);
+  return value ? reinterpret_cast<const char *>(value) : "unknown";
+}
+
+std::string json_escape(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+bool FrameTimer::write_json(std::ostream &out,
+                            const std::string &run_name) const {
+  out << "{\n";
+  out << "  \"run\": \"" << json_escape(run_name) << "\",\n";
+  out << "  \"renderer\": \"" << json_escape(gl_string(GL_RENDERER))
+      << "\",\n";
+  out << "  \"version\": \"" << json_escape(gl_string(GL_VERSION)) << "\",\n";
+  out << "  \"warmup_frames\": " << warmup_frames << ",\n";
+  out << "  \"cpu_ms\": ";
+  write_json_summary(out, summarize(cpu_frame_times));
+  out << ",\n  \"gpu_ms\": ";
+  if (gpu_timing_supported)
+    write_json_summary(out, summarize(gpu_frame_times));
+  else
+    out << "null";
+  std::vector<Metric> padded_metrics = get_metrics();
+  for (const Metric &metric : padded_metrics) {
+    out << ",\n  \"" << json_escape(metric.name) << "\": ";
+    write_json_summary(out, summarize(metric.values));
+  }
+  // a plain number rather than a summary object, there is one per run
+  for (const RunValue &run_value : run_values) {
+    out << ",\n  \"" << json_escape(run_value.name) << "\": ";
+    write_json_number(out, run_value.value);
+  }
+  out << ",\n  \"frames\": [";
+  for (size_t i = 0; i < cpu_frame_times.size(); ++i) {
+    out << (i == 0 ? "\n" : ",\n") << "    {\"cpu_ms\": " << cpu_frame_times[i]
+        << ", \"gpu_ms\": ";
+    write_json_number(out, gpu_frame_times[i]);
+    for (const Metric &metric : padded_metrics) {
+      out << ", \"" << json_escape(metric.name) << "\": ";
+      write_json_number(out, metric.values[i]);
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+bool FrameTimer::write_csv(std::ostream &out) const {
+  std::vector<Metric> padded_metrics = get_metrics();
+  out << "frame,cpu_ms,gpu_ms";
+  for (const Metric &metric : padded_metrics)
+    out << ',' << metric.name;
+  for (const RunValue &run_value : run_values)
+    out << ',' << run_value.name;
+  out << '\n';
+
+  // missing values are left empty
+  auto write_value = [&](double value) {
+    out << ',';
+    if (!std::isnan(value))
+      out << value;
+  };
+  for (size_t i = 0; i < cpu_frame_times.size(); ++i) {
+    out << i << ',' << cpu_frame_times[i];
+    write_value(gpu_frame_times[i]);
+    for (const Metric &metric : padded_metrics)
+      write_value(metric.values[i]);
+    // run values only fill the first row so that they are not mistaken for
+    // per frame samples
+    for (const RunValue &run_value : run_values)
+      write_value(i == 0 ? run_value.value
+                         : std::numeric_limits<double>::quiet_NaN());
+    out << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+bool FrameTimer::write_results(const std::string &path,
+                               const std::string &run_name) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open " << path << " for writing" << std::endl;
+    return false;
+  }
+  file << std::setprecision(6);
+
+  bool is_csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+  bool written = is_csv ? write_csv(file) : write_json(file, run_name);
+  if (!written)
+    std::cerr << "Failed to write results to " << path << std::endl;
+  return written;
+}
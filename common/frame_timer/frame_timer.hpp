@@ -0,0 +1,136 @@
+#ifndef FRAME_TIMER_HPP
+#define FRAME_TIMER_HPP
+
+#include <glad/glad.h>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct FrameTimerOptions {
+  int warmup_frames = 10;
+  // results are written here when set, the extension picks the format
+  // (.json or .csv)
+  std::string output_path;
+  // wraps the draws in DrawStatistics queries, see draw_statistics.hpp
+  bool draw_statistics = false;
+};
+
+// consumes --warmup <n>, --output <path> and --draw-stats from argv, same
+// contract as parse_headless_options
+bool parse_frame_timer_options(int &argc, char *argv[],
+                               FrameTimerOptions &options);
+
+// a run that stops after num_frames frames would keep no samples at all when
+// the warmup covers every frame, clamps the warmup to half the run and warns,
+// call once the frame count is known
+void clamp_warmup_frames(FrameTimerOptions &options, int num_frames);
+
+struct SampleSummary {
+  size_t count = 0;
+  double min = 0.0;
+  double mean = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+  double standard_deviation = 0.0;
+};
+
+SampleSummary summarize(std::vector<double> samples);
+
+// writes the summary as a single line json object, shared with tools that
+// aggregate several runs into one file
+void write_json_summary(std::ostream &out, const SampleSummary &summary);
+
+// escapes the characters json cares about, driver strings and run names are
+// plain ascii in practice
+std::string json_escape(const std::string &text);
+
+// records how long every frame took on the cpu (steady_clock from
+// begin_frame to end_frame) and on the gpu (GL_TIME_ELAPSED queries), the
+// first warmup_frames frames are thrown away, gpu queries are kept in a small
+// ring and read back a few frames late so that timing never stalls the
+// pipeline
+class FrameTimer {
+public:
+  // must be constructed with the context current
+  explicit FrameTimer(int warmup_frames);
+
+  FrameTimer(const FrameTimer &) = delete;
+  FrameTimer &operator=(const FrameTimer &) = delete;
+
+  void begin_frame();
+  void end_frame();
+
+  // attaches an extra per frame measurement to the current frame, e.g. the
+  // time spent uploading, the unit belongs in the name ("upload_ms"), frames
+  // that never record a metric get nan for it
+  void record(const std::string &metric, double value);
+
+  // attaches a measurement that holds for the whole run rather than for a
+  // frame, e.g. the size of a buffer built once, setting it again replaces
+  // the value
+  void set_run_value(const std::string &name, double value);
+
+  // collects the results of every query still in flight and releases the
+  // queries, call once after the last frame while the context is still current
+  void finish();
+
+  bool has_gpu_timing() const { return gpu_timing_supported; }
+
+  // samples are in milliseconds and exclude warmup frames, gpu samples are
+  // nan for frames whose query never became available
+  const std::vector<double> &get_cpu_frame_times() const {
+    return cpu_frame_times;
+  }
+  const std::vector<double> &get_gpu_frame_times() const {
+    return gpu_frame_times;
+  }
+
+  struct Metric {
+    std::string name;
+    std::vector<double> values;
+  };
+  // padded to one value per frame
+  std::vector<Metric> get_metrics() const;
+
+  struct RunValue {
+    std::string name;
+    double value = 0.0;
+  };
+  const std::vector<RunValue> &get_run_values() const { return run_values; }
+
+  void print_summary(std::ostream &out, const std::string &run_name) const;
+
+  // writes the summary and per frame samples to path, the format is chosen by
+  // the extension, returns false if the file could not be written
+  bool write_results(const std::string &path,
+                     const std::string &run_name) const;
+
+private:
+  static constexpr size_t num_queries_in_flight = 4;
+
+  void collect_query(size_t slot);
+  bool write_json(std::ostream &out, const std::string &run_name) const;
+  bool write_csv(std::ostream &out) const;
+
+  int warmup_frames;
+  int frame_index = 0;
+  std::chrono::steady_clock::time_point frame_start_time;
+
+  bool gpu_timing_supported = false;
+  std::array<GLuint, num_queries_in_flight> queries{};
+  // frame index that each query slot measures, -1 when the slot is free
+  std::array<int, num_queries_in_flight> query_frame_indices;
+
+  std::vector<double> cpu_frame_times;
+  std::vector<double> gpu_frame_times;
+  // in order of first appearance so output columns are stable
+  std::vector<Metric> metrics;
+  std::vector<RunValue> run_values;
+};
+
+#endif // FRAME_TIMER_HPP
@@ -0,0 +1,15 @@
+#include "gl_extensions.hpp"
+
+#include <cstring>
+
+bool has_gl_extension(const char *name) {
+  GLint num_extensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+  for (GLint i = 0; i < num_extensions; ++i) {
+    const GLubyte *extension = glGetStringi(GL_EXTENSIONS, i);
+    if (extension != nullptr &&
+        std::strcmp(reinterpret_cast<const char *>(extension), name) == 0)
+      return true;
+  }
+  return false;
+}
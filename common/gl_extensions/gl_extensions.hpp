@@ -0,0 +1,11 @@
+#ifndef GL_EXTENSIONS_HPP
+#define GL_EXTENSIONS_HPP
+
+#include <glad/glad.h>
+
+// whether the current context advertises the extension, glad is generated
+// for core versions only so extensions are looked up at run time through
+// glGetStringi
+bool has_gl_extension(const char *name);
+
+#endif // GL_EXTENSIONS_HPP
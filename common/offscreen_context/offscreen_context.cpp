@@ -0,0 +1,238 @@
+#include "offscreen_context.hpp"
+
+#include <EGL/eglext.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+bool parse_headless_options(int &argc, char *argv[], HeadlessOptions &options) {
+  int write_index = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--headless") {
+      options.enabled = true;
+    } else if (arg == "--frames") {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: --frames requires a value.\n";
+        return false;
+      }
+      options.num_frames = std::atoi(argv[++i]);
+      if (options.num_frames <= 0) {
+        std::cerr << "Error: --frames must be a positive integer.\n";
+        return false;
+      }
+    } else {
+      argv[write_index++] = argv[i];
+    }
+  }
+  argc = write_index;
+  argv[argc] = nullptr;
+  return true;
+}
+
+static bool has_extension(const char *extensions, const char *name) {
+  if (extensions == nullptr)
+    return false;
+  size_t name_length = std::strlen(name);
+  for (const char *start = extensions; (start = std::strstr(start, name));
+       start += name_length) {
+    bool at_word_start = start == extensions || start[-1] == ' ';
+    char end = start[name_length];
+    if (at_word_start && (end == ' ' || end == '\0'))
+      return true;
+  }
+  return false;
+}
+
+OffscreenContext::OffscreenContext(int width, int height, int gl_major_version,
+                                   int gl_minor_version)
+    : width(width), height(height), gl_major_version(gl_major_version),
+      gl_minor_version(gl_minor_version) {}
+
+OffscreenContext::~OffscreenContext() {
+  if (context != EGL_NO_CONTEXT) {
+    // gl names only exist once glad has been loaded
+    if (color_renderbuffer != 0) {
+      glDeleteFramebuffers(1, &framebuffer);
+      glDeleteRenderbuffers(1, &color_renderbuffer);
+      glDeleteRenderbuffers(1, &depth_renderbuffer);
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+  }
+  if (surface != EGL_NO_SURFACE)
+    eglDestroySurface(display, surface);
+  if (display != EGL_NO_DISPLAY)
+    eglTerminate(display);
+}
+
+bool OffscreenContext::create_display() {
+  const char *client_extensions =
+      eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  // prefer the surfaceless platform, it needs neither a display server nor a
+  // gpu device node, and fall back to whatever the default display is
+  if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    auto get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+            "eglGetPlatformDisplayEXT");
+    if (get_platform_display != nullptr)
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                     EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (display == EGL_NO_DISPLAY)
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  if (display == EGL_NO_DISPLAY) {
+    std::cerr << "Failed to get an EGL display" << std::endl;
+    return false;
+  }
+
+  EGLint major, minor;
+  if (!eglInitialize(display, &major, &minor)) {
+    std::cerr << "Failed to initialize EGL (error 0x" << std::hex
+              << eglGetError() << std::dec << ")" << std::endl;
+    display = EGL_NO_DISPLAY;
+    return false;
+  }
+  return true;
+}
+
+EGLContext OffscreenContext::create_context(EGLContext share_context) {
+  const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                       gl_major_version,
+                                       EGL_CONTEXT_MINOR_VERSION,
+                                       gl_minor_version,
+                                       EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                       EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                       EGL_NONE};
+  EGLContext created =
+      eglCreateContext(display, config, share_context, context_attributes);
+  if (created == EGL_NO_CONTEXT)
+    std::cerr << "Failed to create an OpenGL " << gl_major_version << "."
+              << gl_minor_version << " context through EGL" << std::endl;
+  return created;
+}
+
+bool OffscreenContext::create_surface(EGLSurface &created) {
+  created = EGL_NO_SURFACE;
+  const char *display_extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (has_extension(display_extensions, "EGL_KHR_surfaceless_context"))
+    return true;
+
+  const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+  created = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+  if (created == EGL_NO_SURFACE) {
+    std::cerr << "Failed to create an EGL pbuffer surface" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool OffscreenContext::initialize() {
+  if (!create_display())
+    return false;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    std::cerr << "Failed to bind the desktop OpenGL API" << std::endl;
+    return false;
+  }
+
+  const EGLint config_attributes[] = {EGL_SURFACE_TYPE,
+                                      EGL_PBUFFER_BIT,
+                                      EGL_RENDERABLE_TYPE,
+                                      EGL_OPENGL_BIT,
+                                      EGL_RED_SIZE,
+                                      8,
+                                      EGL_GREEN_SIZE,
+                                      8,
+                                      EGL_BLUE_SIZE,
+                                      8,
+                                      EGL_NONE};
+  EGLint num_configs = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &num_configs) ||
+      num_configs == 0) {
+    std::cerr << "Failed to find a suitable EGL config" << std::endl;
+    return false;
+  }
+
+  context = create_context(EGL_NO_CONTEXT);
+  if (context == EGL_NO_CONTEXT)
+    return false;
+
+  // the framebuffer object is what we actually render into, a surface is only
+  // created for implementations that cannot make a context current without one
+  if (!create_surface(surface))
+    return false;
+
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    std::cerr << "Failed to make the EGL context current" << std::endl;
+    return false;
+  }
+
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    std::cerr << "Failed to initialize GLAD" << std::endl;
+    return false;
+  }
+
+  return create_framebuffer();
+}
+
+bool OffscreenContext::create_framebuffer() {
+  glGenRenderbuffers(1, &color_renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depth_renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color_renderbuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+    return false;
+  }
+
+  glViewport(0, 0, width, height);
+  return true;
+}
+
+void OffscreenContext::present() { glFinish(); }
+
+bool OffscreenContext::create_shared_context(EGLContext &shared_context,
+                                             EGLSurface &shared_surface) {
+  shared_context = create_context(context);
+  if (shared_context == EGL_NO_CONTEXT)
+    return false;
+  if (!create_surface(shared_surface)) {
+    eglDestroyContext(display, shared_context);
+    shared_context = EGL_NO_CONTEXT;
+    return false;
+  }
+  return true;
+}
+
+bool OffscreenContext::make_shared_context_current(EGLContext shared_context,
+                                                   EGLSurface shared_surface) {
+  // the bound api is per thread
+  if (!eglBindAPI(EGL_OPENGL_API))
+    return false;
+  return eglMakeCurrent(display, shared_surface, shared_surface,
+                        shared_context) == EGL_TRUE;
+}
+
+void OffscreenContext::destroy_shared_context(EGLContext shared_context,
+                                              EGLSurface shared_surface) {
+  if (shared_context != EGL_NO_CONTEXT)
+    eglDestroyContext(display, shared_context);
+  if (shared_surface != EGL_NO_SURFACE)
+    eglDestroySurface(display, shared_surface);
+}
@@ -0,0 +1,77 @@
+#ifndef OFFSCREEN_CONTEXT_HPP
+#define OFFSCREEN_CONTEXT_HPP
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+
+// options shared by every benchmark executable for running without a display
+struct HeadlessOptions {
+  bool enabled = false;
+  int num_frames = 1000;
+};
+
+// consumes --headless and --frames <n> from argv so that the remaining
+// positional arguments can be parsed by the caller as before, returns false if
+// one of the flags was malformed
+bool parse_headless_options(int &argc, char *argv[], HeadlessOptions &options);
+
+// an opengl context with no window and no display, created through egl on the
+// mesa surfaceless platform (llvmpipe when there is no gpu), rendering goes
+// into a framebuffer object of the requested size instead of a swapchain
+class OffscreenContext {
+public:
+  OffscreenContext(int width, int height, int gl_major_version,
+                   int gl_minor_version);
+  ~OffscreenContext();
+
+  OffscreenContext(const OffscreenContext &) = delete;
+  OffscreenContext &operator=(const OffscreenContext &) = delete;
+
+  // creates the context, makes it current, loads gl through glad and binds the
+  // offscreen framebuffer, returns false and logs the reason on failure
+  bool initialize();
+
+  // stands in for glfwSwapBuffers, waits for the frame to finish so that each
+  // frame is fully accounted for before the next one starts
+  void present();
+
+  // a context sharing objects with this one, for another thread to make
+  // current with make_shared_context_current, it gets a 1x1 pbuffer of its
+  // own when the implementation cannot make a context current without one,
+  // returns false and logs the reason on failure
+  bool create_shared_context(EGLContext &shared_context,
+                             EGLSurface &shared_surface);
+  // binds the shared context to the calling thread, or releases whatever is
+  // current on it when shared_context is EGL_NO_CONTEXT
+  bool make_shared_context_current(EGLContext shared_context,
+                                   EGLSurface shared_surface);
+  // the shared context must no longer be current on any thread
+  void destroy_shared_context(EGLContext shared_context,
+                              EGLSurface shared_surface);
+
+  int width;
+  int height;
+
+private:
+  bool create_display();
+  // a context with the requested version, logs on failure
+  EGLContext create_context(EGLContext share_context);
+  // EGL_NO_SURFACE when contexts can be made current without one, otherwise a
+  // 1x1 pbuffer, returns false and logs on failure
+  bool create_surface(EGLSurface &created);
+  bool create_framebuffer();
+
+  int gl_major_version;
+  int gl_minor_version;
+
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLConfig config = nullptr;
+  EGLContext context = EGL_NO_CONTEXT;
+  EGLSurface surface = EGL_NO_SURFACE;
+
+  GLuint framebuffer = 0;
+  GLuint color_renderbuffer = 0;
+  GLuint depth_renderbuffer = 0;
+};
+
+#endif // OFFSCREEN_CONTEXT_HPP
@@ -0,0 +1,25 @@
+#include "pass_timer.hpp"
+
+PassTimer::PassTimer() { glGenQueries(queries.size(), queries.data()); }
+
+PassTimer::~PassTimer() { glDeleteQueries(queries.size(), queries.data()); }
+
+void PassTimer::begin() {
+  if (pending[slot]) {
+    // num_slots frames later the result is almost always ready, if not this
+    // blocks until it is
+    GLuint64 start_time, end_time;
+    glGetQueryObjectui64v(queries[slot * 2], GL_QUERY_RESULT, &start_time);
+    glGetQueryObjectui64v(queries[slot * 2 + 1], GL_QUERY_RESULT, &end_time);
+    latest = (end_time - start_time) / 1e6;
+    has_latest = true;
+    pending[slot] = false;
+  }
+  glQueryCounter(queries[slot * 2], GL_TIMESTAMP);
+}
+
+void PassTimer::end() {
+  glQueryCounter(queries[slot * 2 + 1], GL_TIMESTAMP);
+  pending[slot] = true;
+  slot = (slot + 1) % num_slots;
+}
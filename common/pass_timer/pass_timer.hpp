@@ -0,0 +1,47 @@
+#ifndef PASS_TIMER_HPP
+#define PASS_TIMER_HPP
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+
+// the gpu time of one pass per frame, measured with a pair of GL_TIMESTAMP
+// queries rather than GL_TIME_ELAPSED since the frame timer's elapsed query is
+// already active around the whole frame and elapsed queries do not nest, the
+// pairs are kept in a ring of num_slots and a pair is read back when its slot
+// comes around again, so the latest result belongs to a pass num_slots frames
+// back and reading it almost never waits on the gpu
+class PassTimer {
+public:
+  static constexpr size_t num_slots = 4;
+
+  // must be constructed and destroyed with the context current
+  PassTimer();
+  ~PassTimer();
+
+  PassTimer(const PassTimer &) = delete;
+  PassTimer &operator=(const PassTimer &) = delete;
+
+  // reads back the result of the pass that last used this frame's slot, then
+  // starts timing
+  void begin();
+  // stops timing and moves on to the next slot
+  void end();
+
+  // the slot the next begin / end pair uses, for callers that read back data
+  // of their own in step with the timings
+  size_t get_slot() const { return slot; }
+
+  // false until the first pass has been read back
+  bool has_result() const { return has_latest; }
+  double latest_ms() const { return latest; }
+
+private:
+  std::array<GLuint, num_slots * 2> queries{};
+  std::array<bool, num_slots> pending{};
+  size_t slot = 0;
+  bool has_latest = false;
+  double latest = 0.0;
+};
+
+#endif // PASS_TIMER_HPP
@@ -0,0 +1,38 @@
+#include "ppm_image.hpp"
+
+#include <fstream>
+#include <iostream>
+
+bool write_ppm(const std::string &path, const Image &image) {
+  std::ofstream file(path, std::ios::binary);
+  file << "P6\n" << image.width << ' ' << image.height << "\n255\n";
+  file.write(reinterpret_cast<const char *>(image.pixels.data()),
+             image.pixels.size());
+  if (!file) {
+    std::cerr << "Failed to write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool read_ppm(const std::string &path, Image &image) {
+  std::ifstream file(path, std::ios::binary);
+  std::string magic;
+  int max_value = 0;
+  file >> magic >> image.width >> image.height >> max_value;
+  // exactly one whitespace character separates the header from the pixels
+  file.get();
+  if (!file || magic != "P6" || max_value != 255 || image.width <= 0 ||
+      image.height <= 0) {
+    std::cerr << "Not an 8 bit binary ppm: " << path << std::endl;
+    return false;
+  }
+  image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+  file.read(reinterpret_cast<char *>(image.pixels.data()),
+            image.pixels.size());
+  if (!file) {
+    std::cerr << "Truncated image: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
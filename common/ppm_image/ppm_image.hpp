@@ -0,0 +1,21 @@
+#ifndef PPM_IMAGE_HPP
+#define PPM_IMAGE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 8 bit rgb, rows top to bottom
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+// binary ppm (P6), a header and the raw rows, so writing streams straight
+// from memory with no encoder and any image viewer or diff tool reads it,
+// both return false and log the reason on failure
+bool write_ppm(const std::string &path, const Image &image);
+bool read_ppm(const std::string &path, Image &image);
+
+#endif // PPM_IMAGE_HPP
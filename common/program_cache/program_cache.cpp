@@ -0,0 +1,182 @@
+#include "program_cache.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+bool parse_program_cache_options(int &argc, char *argv[],
+                                 ProgramCacheOptions &options) {
+  int write_index = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--program-cache") {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: --program-cache requires a directory.\n";
+        return false;
+      }
+      options.directory = argv[++i];
+    } else {
+      argv[write_index++] = argv[i];
+    }
+  }
+  argc = write_index;
+  argv[argc] = nullptr;
+  return true;
+}
+
+static std::string cache_directory;
+
+void set_program_cache_directory(const std::string &directory) {
+  cache_directory = directory;
+  if (directory.empty())
+    return;
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+    std::cerr << "program cache: cannot create " << directory << ": "
+              << error.message() << std::endl;
+}
+
+bool is_program_cache_active() {
+  if (cache_directory.empty() || !GLAD_GL_VERSION_4_1)
+    return false;
+  GLint num_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+  return num_formats > 0;
+}
+
+static std::string gl_string(GLenum name) {
+  const GLubyte *value = glGetString(name);
+  return value ? reinterpret_cast<const char *>(value) : "";
+}
+
+// everything a stored binary depends on, the driver that produced it and the
+// exact sources, kept in the file and compared in full on load so that a hash
+// collision can never hand out the wrong program
+static std::string get_cache_key(std::span<const ShaderStageSource> stages) {
+  std::string key = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) +
+                    '\n' + gl_string(GL_VERSION) + '\n';
+  for (const ShaderStageSource &stage : stages) {
+    key += std::to_string(stage.type) + '\n';
+    key += stage.source;
+    key += '\n';
+  }
+  return key;
+}
+
+// 64 bit fnv-1a, stable across builds and platforms unlike std::hash
+static uint64_t hash_key(const std::string &key) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static std::filesystem::path get_cache_path(const std::string &key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin",
+                static_cast<unsigned long long>(hash_key(key)));
+  return std::filesystem::path(cache_directory) / name;
+}
+
+// file layout: magic, key length, key, binary format, binary length, binary
+static constexpr char cache_magic[8] = {'T', 'R', 'I', 'B', 'P', 'R', 'G', '1'};
+
+static bool read_u32(std::istream &in, uint32_t &value) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+static void write_u32(std::ostream &out, uint32_t value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+GLuint load_cached_program(std::span<const ShaderStageSource> stages) {
+  std::string key = get_cache_key(stages);
+  std::ifstream in(get_cache_path(key), std::ios::binary);
+  if (!in)
+    return 0;
+
+  char magic[sizeof(cache_magic)];
+  uint32_t key_length = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic), std::end(magic),
+                  std::begin(cache_magic)) ||
+      !read_u32(in, key_length) || key_length != key.size())
+    return 0;
+
+  std::string stored_key(key_length, '\0');
+  uint32_t format = 0, binary_length = 0;
+  if (!in.read(stored_key.data(), key_length) || stored_key != key ||
+      !read_u32(in, format) || !read_u32(in, binary_length))
+    return 0;
+
+  std::vector<char> binary(binary_length);
+  if (!in.read(binary.data(), binary_length))
+    return 0;
+
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, format, binary.data(), binary_length);
+
+  GLint success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+
+void prepare_program_for_cache(GLuint program) {
+  glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void store_cached_program(std::span<const ShaderStageSource> stages,
+                          GLuint program) {
+  GLint binary_length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+  if (binary_length <= 0)
+    return;
+
+  std::vector<char> binary(binary_length);
+  GLenum format = 0;
+  glGetProgramBinary(program, binary_length, &binary_length, &format,
+                     binary.data());
+  if (binary_length <= 0)
+    return;
+
+  // written next to the final name and renamed into place, so that a reader
+  // never sees a partial file
+  std::string key = get_cache_key(stages);
+  std::filesystem::path path = get_cache_path(key);
+  std::filesystem::path temporary_path = path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+    out.write(cache_magic, sizeof(cache_magic));
+    write_u32(out, static_cast<uint32_t>(key.size()));
+    out.write(key.data(), key.size());
+    write_u32(out, format);
+    write_u32(out, static_cast<uint32_t>(binary_length));
+    out.write(binary.data(), binary_length);
+    if (!out) {
+      std::cerr << "program cache: cannot write " << temporary_path.string()
+                << std::endl;
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+  if (error)
+    std::cerr << "program cache: cannot write " << path.string() << ": "
+              << error.message() << std::endl;
+}
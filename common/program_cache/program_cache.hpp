@@ -0,0 +1,47 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <glad/glad.h>
+#include <span>
+#include <string>
+
+struct ProgramCacheOptions {
+  // linked programs are stored here and reused by later runs, the cache is
+  // off when empty
+  std::string directory;
+};
+
+// consumes --program-cache <dir> from argv, same contract as
+// parse_headless_options
+bool parse_program_cache_options(int &argc, char *argv[],
+                                 ProgramCacheOptions &options);
+
+// turns the process wide cache on for every program built through
+// shader_utils, the directory is created if needed
+void set_program_cache_directory(const std::string &directory);
+
+// one stage of a program, in the order the stages are attached
+struct ShaderStageSource {
+  GLenum type;
+  const char *source;
+};
+
+// whether programs built on the current context go through the cache, needs
+// a directory, gl 4.1 (glGetProgramBinary) and at least one binary format
+bool is_program_cache_active();
+
+// a program linked from the binary stored for these sources on this driver,
+// 0 when there is none or the driver rejects it (after an update the stored
+// format usually no longer matches), the caller then compiles as usual
+GLuint load_cached_program(std::span<const ShaderStageSource> stages);
+
+// call before linking a program that will be stored, some drivers only keep
+// a retrievable binary when asked to
+void prepare_program_for_cache(GLuint program);
+
+// writes the linked program's binary under the key of its sources, a failure
+// to write is logged and otherwise ignored
+void store_cached_program(std::span<const ShaderStageSource> stages,
+                          GLuint program);
+
+#endif // PROGRAM_CACHE_HPP
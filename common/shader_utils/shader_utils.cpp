@@ -0,0 +1,130 @@
+#include "shader_utils.hpp"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <span>
+
+#include "program_cache/program_cache.hpp"
+
+static ProgramBuildStats build_stats;
+
+const ProgramBuildStats &get_program_build_stats() { return build_stats; }
+
+void reset_program_build_stats() { build_stats = ProgramBuildStats(); }
+
+void add_program_build_stats(const ProgramBuildStats &stats) {
+  build_stats.programs_compiled += stats.programs_compiled;
+  build_stats.programs_loaded += stats.programs_loaded;
+  build_stats.compile_ms += stats.compile_ms;
+  build_stats.link_ms += stats.link_ms;
+  build_stats.cache_load_ms += stats.cache_load_ms;
+}
+
+static double milliseconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+GLuint compile_shader(const char *source, GLenum type) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+
+  GLint success;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    char infoLog[512];
+    glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+    std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+// loads the program from the cache or compiles every stage and links them,
+// storing the result for the next run, varyings are captured by transform
+// feedback
+static GLuint build_program(std::span<const ShaderStageSource> stages,
+                            std::span<const char *const> varyings = {}) {
+  bool use_cache = is_program_cache_active() && varyings.empty();
+  if (use_cache) {
+    auto load_start = std::chrono::steady_clock::now();
+    GLuint program = load_cached_program(stages);
+    build_stats.cache_load_ms += milliseconds_since(load_start);
+    if (program != 0) {
+      ++build_stats.programs_loaded;
+      return program;
+    }
+  }
+
+  auto compile_start = std::chrono::steady_clock::now();
+  std::array<GLuint, 2> shaders{};
+  bool compiled = true;
+  for (size_t i = 0; i < stages.size(); ++i) {
+    shaders[i] = compile_shader(stages[i].source, stages[i].type);
+    compiled = compiled && shaders[i] != 0;
+  }
+  build_stats.compile_ms += milliseconds_since(compile_start);
+  if (!compiled) {
+    for (GLuint shader : shaders)
+      glDeleteShader(shader);
+    return 0;
+  }
+
+  auto link_start = std::chrono::steady_clock::now();
+  GLuint program = glCreateProgram();
+  for (size_t i = 0; i < stages.size(); ++i)
+    glAttachShader(program, shaders[i]);
+  if (use_cache)
+    prepare_program_for_cache(program);
+  if (!varyings.empty())
+    glTransformFeedbackVaryings(program, varyings.size(), varyings.data(),
+                                GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(program);
+
+  for (GLuint shader : shaders)
+    glDeleteShader(shader);
+
+  GLint success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  build_stats.link_ms += milliseconds_since(link_start);
+  if (!success) {
+    char infoLog[512];
+    glGetProgramInfoLog(program, 512, nullptr, infoLog);
+    std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  ++build_stats.programs_compiled;
+  if (use_cache)
+    store_cached_program(stages, program);
+  return program;
+}
+
+GLuint create_shader_program(const char *vertex_source,
+                             const char *fragment_source) {
+  std::array<ShaderStageSource, 2> stages = {{
+      {GL_VERTEX_SHADER, vertex_source},
+      {GL_FRAGMENT_SHADER, fragment_source},
+  }};
+  return build_program(stages);
+}
+
+GLuint create_compute_program(const char *compute_source) {
+  std::array<ShaderStageSource, 1> stages = {{
+      {GL_COMPUTE_SHADER, compute_source},
+  }};
+  return build_program(stages);
+}
+
+GLuint create_transform_feedback_program(
+    const char *vertex_source, std::span<const char *const> varyings) {
+  std::array<ShaderStageSource, 1> stages = {{
+      {GL_VERTEX_SHADER, vertex_source},
+  }};
+  return build_program(stages, varyings);
+}
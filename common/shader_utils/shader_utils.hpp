@@ -0,0 +1,45 @@
+#ifndef SHADER_UTILS_HPP
+#define SHADER_UTILS_HPP
+
+#include <glad/glad.h>
+#include <span>
+
+// compiles a single shader stage, logs the info log and returns 0 on failure
+GLuint compile_shader(const char *source, GLenum type);
+
+// compiles and links a vertex + fragment program, the intermediate shader
+// objects are released, returns 0 on failure, goes through the program cache
+// when one is set (program_cache.hpp)
+GLuint create_shader_program(const char *vertex_source,
+                             const char *fragment_source);
+
+// compiles and links a single compute shader (gl 4.3), returns 0 on failure,
+// cached like create_shader_program
+GLuint create_compute_program(const char *compute_source);
+
+// compiles and links a vertex shader on its own, the outputs named in
+// varyings are captured interleaved by transform feedback, for passes that
+// run with GL_RASTERIZER_DISCARD, returns 0 on failure, never cached since
+// the capture list is not part of the cache key
+GLuint create_transform_feedback_program(
+    const char *vertex_source, std::span<const char *const> varyings);
+
+// time spent building programs through the functions above and shader
+// variant sets since the last reset, on the cpu, drivers that defer work to
+// the first draw hide part of it from these numbers
+struct ProgramBuildStats {
+  int programs_compiled = 0;
+  // programs that came out of the cache instead of being compiled
+  int programs_loaded = 0;
+  double compile_ms = 0.0;
+  double link_ms = 0.0;
+  // reading the file and glProgramBinary, including rejected binaries
+  double cache_load_ms = 0.0;
+};
+
+const ProgramBuildStats &get_program_build_stats();
+void reset_program_build_stats();
+// adds programs built outside this file to the totals
+void add_program_build_stats(const ProgramBuildStats &stats);
+
+#endif // SHADER_UTILS_HPP
@@ -0,0 +1,263 @@
+#include "shader_variants.hpp"
+
+#include <GLFW/glfw3.h>
+#include <EGL/egl.h>
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "gl_extensions/gl_extensions.hpp"
+#include "program_cache/program_cache.hpp"
+#include "shader_utils/shader_utils.hpp"
+
+// KHR_parallel_shader_compile, glad is generated for core versions only
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void(APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+static double milliseconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+ShaderDefines &ShaderDefines::set(const std::string &name, int value) {
+  return set_value(name, std::to_string(value));
+}
+
+ShaderDefines &ShaderDefines::set(const std::string &name, bool value) {
+  return set_value(name, value ? "1" : "0");
+}
+
+ShaderDefines &ShaderDefines::set_symbol(const std::string &name,
+                                         const std::string &symbol) {
+  return set_value(name, symbol);
+}
+
+ShaderDefines &ShaderDefines::set_value(const std::string &name,
+                                        std::string value) {
+  auto position = std::lower_bound(
+      values.begin(), values.end(), name,
+      [](const auto &entry, const std::string &key) {
+        return entry.first < key;
+      });
+  if (position != values.end() && position->first == name)
+    position->second = std::move(value);
+  else
+    values.insert(position, {name, std::move(value)});
+  return *this;
+}
+
+std::string ShaderDefines::to_glsl() const {
+  std::string glsl;
+  for (const auto &[name, value] : values)
+    glsl += "#define " + name + " " + value + "\n";
+  return glsl;
+}
+
+std::string ShaderDefines::describe() const {
+  std::string description;
+  for (const auto &[name, value] : values) {
+    if (!description.empty())
+      description += ",";
+    description += name + "=" + value;
+  }
+  return description;
+}
+
+// the defines have to follow #version, which has to come first
+static std::string apply_defines(const char *source,
+                                 const std::string &defines) {
+  std::string result = source;
+  size_t version = result.find("#version");
+  if (version == std::string::npos)
+    return defines + result;
+  size_t line_end = result.find('\n', version);
+  if (line_end == std::string::npos) {
+    result += '\n';
+    line_end = result.size() - 1;
+  }
+  result.insert(line_end + 1, defines);
+  return result;
+}
+
+void ShaderVariantSet::clear() {
+  for (Variant &variant : variants) {
+    glDeleteShader(variant.vertex_shader);
+    glDeleteShader(variant.fragment_shader);
+    glDeleteProgram(variant.program);
+  }
+  variants.clear();
+}
+
+size_t ShaderVariantSet::add(const ShaderTemplate &shader,
+                             const ShaderDefines &defines) {
+  std::string key =
+      std::string(shader.name) + "[" + defines.describe() + "]";
+  for (size_t i = 0; i < variants.size(); ++i)
+    if (variants[i].key == key)
+      return i;
+
+  Variant variant;
+  variant.key = key;
+  variant.stats.name = key;
+  std::string glsl = defines.to_glsl();
+  variant.vertex_source = apply_defines(shader.vertex_source, glsl);
+  variant.fragment_source = apply_defines(shader.fragment_source, glsl);
+  variants.push_back(std::move(variant));
+  return variants.size() - 1;
+}
+
+static void log_failed_variant(const std::string &name, GLuint program,
+                               std::initializer_list<GLuint> shaders) {
+  std::array<char, 1024> info_log;
+  std::cerr << "Failed to build shader variant " << name << std::endl;
+  for (GLuint shader : shaders) {
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+      glGetShaderInfoLog(shader, info_log.size(), nullptr, info_log.data());
+      std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n"
+                << info_log.data() << std::endl;
+    }
+  }
+  glGetProgramInfoLog(program, info_log.size(), nullptr, info_log.data());
+  std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n"
+            << info_log.data() << std::endl;
+}
+
+bool ShaderVariantSet::build() {
+  auto batch_start = std::chrono::steady_clock::now();
+  ProgramBuildStats stats;
+  bool use_cache = is_program_cache_active();
+
+  std::vector<Variant *> pending;
+  for (Variant &variant : variants) {
+    if (variant.built)
+      continue;
+    variant.built = true;
+    if (use_cache) {
+      std::array<ShaderStageSource, 2> stages = {{
+          {GL_VERTEX_SHADER, variant.vertex_source.c_str()},
+          {GL_FRAGMENT_SHADER, variant.fragment_source.c_str()},
+      }};
+      auto load_start = std::chrono::steady_clock::now();
+      variant.program = load_cached_program(stages);
+      stats.cache_load_ms += milliseconds_since(load_start);
+      if (variant.program != 0) {
+        variant.stats.from_cache = true;
+        variant.stats.ready_ms = milliseconds_since(batch_start);
+        ++stats.programs_loaded;
+        continue;
+      }
+    }
+    pending.push_back(&variant);
+  }
+
+  // glad only loads core functions, the extension's entry point is looked up
+  // through whichever api made the context current
+  parallel_compile = !pending.empty() &&
+                     has_gl_extension("GL_KHR_parallel_shader_compile");
+  if (parallel_compile) {
+    const char *name = "glMaxShaderCompilerThreadsKHR";
+    auto max_compiler_threads = reinterpret_cast<MaxShaderCompilerThreadsProc>(
+        glfwGetCurrentContext() != nullptr
+            ? reinterpret_cast<void (*)()>(glfwGetProcAddress(name))
+            : reinterpret_cast<void (*)()>(eglGetProcAddress(name)));
+    // as many threads as the driver is willing to use
+    if (max_compiler_threads != nullptr)
+      max_compiler_threads(0xFFFFFFFF);
+  }
+
+  auto compile_start = std::chrono::steady_clock::now();
+  for (Variant *variant : pending) {
+    const char *vertex_source = variant->vertex_source.c_str();
+    const char *fragment_source = variant->fragment_source.c_str();
+    variant->vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(variant->vertex_shader, 1, &vertex_source, nullptr);
+    glCompileShader(variant->vertex_shader);
+    variant->fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(variant->fragment_shader, 1, &fragment_source, nullptr);
+    glCompileShader(variant->fragment_shader);
+  }
+  stats.compile_ms = milliseconds_since(compile_start);
+
+  // a link whose shaders failed to compile fails too, the compile logs are
+  // only read then
+  auto link_start = std::chrono::steady_clock::now();
+  for (Variant *variant : pending) {
+    variant->program = glCreateProgram();
+    glAttachShader(variant->program, variant->vertex_shader);
+    glAttachShader(variant->program, variant->fragment_shader);
+    if (use_cache)
+      prepare_program_for_cache(variant->program);
+    glLinkProgram(variant->program);
+  }
+
+  // without the extension the first status query blocks until that program
+  // is done, with it the programs are polled and each is timed as it
+  // finishes
+  std::vector<Variant *> linking = pending;
+  while (!linking.empty()) {
+    auto still_linking = linking.begin();
+    for (Variant *variant : linking) {
+      if (parallel_compile) {
+        GLint done;
+        glGetProgramiv(variant->program, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) {
+          *still_linking++ = variant;
+          continue;
+        }
+      }
+      GLint linked;
+      glGetProgramiv(variant->program, GL_LINK_STATUS, &linked);
+      variant->stats.ready_ms = milliseconds_since(batch_start);
+      if (!linked) {
+        log_failed_variant(variant->key, variant->program,
+                           {variant->vertex_shader, variant->fragment_shader});
+        glDeleteProgram(variant->program);
+        variant->program = 0;
+      }
+    }
+    linking.erase(still_linking, linking.end());
+    if (!linking.empty())
+      std::this_thread::yield();
+  }
+  stats.link_ms = milliseconds_since(link_start);
+
+  bool all_linked = true;
+  for (Variant *variant : pending) {
+    glDeleteShader(variant->vertex_shader);
+    glDeleteShader(variant->fragment_shader);
+    variant->vertex_shader = variant->fragment_shader = 0;
+    if (variant->program == 0) {
+      all_linked = false;
+      continue;
+    }
+    ++stats.programs_compiled;
+    if (use_cache) {
+      std::array<ShaderStageSource, 2> stages = {{
+          {GL_VERTEX_SHADER, variant->vertex_source.c_str()},
+          {GL_FRAGMENT_SHADER, variant->fragment_source.c_str()},
+      }};
+      store_cached_program(stages, variant->program);
+    }
+  }
+  add_program_build_stats(stats);
+  return all_linked;
+}
+
+void ShaderVariantSet::print_stats(std::ostream &out) const {
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+  for (const Variant &variant : variants)
+    out << "  " << variant.stats.name << ": ready after "
+        << variant.stats.ready_ms << " ms"
+        << (variant.stats.from_cache ? " (from cache)" : "") << '\n';
+  out.flags(flags);
+  out.precision(precision);
+}
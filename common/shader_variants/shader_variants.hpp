@@ -0,0 +1,109 @@
+#ifndef SHADER_VARIANTS_HPP
+#define SHADER_VARIANTS_HPP
+
+#include <glad/glad.h>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the values a template is compiled with, each becomes a #define right after
+// the #version line, kept sorted by name so that equal values always give the
+// same source
+class ShaderDefines {
+public:
+  ShaderDefines &set(const std::string &name, int value);
+  // 1 or 0, for #if
+  ShaderDefines &set(const std::string &name, bool value);
+  // an identifier, for modes the template tells apart with
+  // #if defined(...) or by comparing against defines of its own
+  ShaderDefines &set_symbol(const std::string &name,
+                            const std::string &symbol);
+
+  // "#define NAME VALUE\n" per value
+  std::string to_glsl() const;
+  // NAME=VALUE,..., for reports and as part of the variant's key
+  std::string describe() const;
+
+private:
+  ShaderDefines &set_value(const std::string &name, std::string value);
+
+  std::vector<std::pair<std::string, std::string>> values;
+};
+
+// a vertex + fragment program written once with #if and the defined values in
+// place of the numbers and modes that vary
+struct ShaderTemplate {
+  // identifies the template in reports and in the variant keys, unique per
+  // template
+  const char *name;
+  const char *vertex_source;
+  const char *fragment_source;
+};
+
+struct ShaderVariantStats {
+  // <template name>[NAME=VALUE,...]
+  std::string name;
+  // from the start of the batch until the program was linked, compiles
+  // overlap so these add up to more than the batch took
+  double ready_ms = 0.0;
+  bool from_cache = false;
+};
+
+// collects the variants a run needs, shares one program between identical
+// ones and builds them together: every compile and link is issued before any
+// status is read so that drivers compiling in the background overlap them,
+// with KHR_parallel_shader_compile on as many threads as the driver allows,
+// programs go through the program cache like create_shader_program and the
+// set owns them (the context is still current when it is destroyed)
+class ShaderVariantSet {
+public:
+  ShaderVariantSet() = default;
+  ~ShaderVariantSet() { clear(); }
+
+  ShaderVariantSet(const ShaderVariantSet &) = delete;
+  ShaderVariantSet &operator=(const ShaderVariantSet &) = delete;
+
+  // returns the index of the variant, the same template with the same
+  // defines returns the same index
+  size_t add(const ShaderTemplate &shader, const ShaderDefines &defines);
+
+  // builds every variant added since the last build, returns false and logs
+  // each failing variant's info log when one does not compile or link
+  bool build();
+
+  // 0 until the variant is built
+  GLuint get_program(size_t variant) const {
+    return variants[variant].program;
+  }
+  size_t size() const { return variants.size(); }
+  const ShaderVariantStats &get_stats(size_t variant) const {
+    return variants[variant].stats;
+  }
+  // whether the last build compiled through KHR_parallel_shader_compile
+  bool used_parallel_compile() const { return parallel_compile; }
+
+  // one line per variant with its ready time
+  void print_stats(std::ostream &out) const;
+
+  // deletes every program and forgets the variants, for owners that outlive
+  // their context
+  void clear();
+
+private:
+  struct Variant {
+    std::string key;
+    std::string vertex_source;
+    std::string fragment_source;
+    GLuint vertex_shader = 0;
+    GLuint fragment_shader = 0;
+    GLuint program = 0;
+    bool built = false;
+    ShaderVariantStats stats;
+  };
+
+  std::vector<Variant> variants;
+  bool parallel_compile = false;
+};
+
+#endif // SHADER_VARIANTS_HPP
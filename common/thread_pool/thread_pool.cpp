@@ -0,0 +1,96 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+  for (unsigned i = 0; i < num_threads; ++i)
+    workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  task_available.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+void ThreadPool::worker_loop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_available.wait(lock, [&] { return stopping || !tasks.empty(); });
+      if (tasks.empty())
+        return;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+      ++num_running;
+    }
+
+    task();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --num_running;
+      if (tasks.empty() && num_running == 0)
+        idle.notify_all();
+    }
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  if (workers.empty()) {
+    task();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+  }
+  task_available.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [&] { return tasks.empty() && num_running == 0; });
+}
+
+void ThreadPool::parallel_for(size_t count,
+                              const std::function<void(size_t, size_t)> &task,
+                              size_t min_range_size) {
+  if (count == 0)
+    return;
+
+  size_t max_ranges = workers.size() + 1;
+  size_t num_ranges = std::clamp<size_t>(
+      count / std::max<size_t>(min_range_size, 1), 1, max_ranges);
+  size_t range_size = (count + num_ranges - 1) / num_ranges;
+  num_ranges = (count + range_size - 1) / range_size;
+
+  // waits on its own counter rather than wait_idle so unrelated tasks in the
+  // queue do not hold it up, the counter and the notify stay under done_mutex
+  // since the caller may return, ending their lifetime, as soon as it sees
+  // remaining reach zero
+  size_t remaining = num_ranges - 1;
+  std::mutex done_mutex;
+  std::condition_variable done;
+
+  for (size_t range = 1; range < num_ranges; ++range) {
+    size_t first = range * range_size;
+    size_t last = std::min(count, first + range_size);
+    submit([&, first, last] {
+      task(first, last);
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (--remaining == 0)
+        done.notify_one();
+    });
+  }
+
+  task(0, std::min(count, range_size));
+
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done.wait(lock, [&] { return remaining == 0; });
+}
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads pulling tasks from one queue, used for
+// cpu side data generation, none of the tasks may touch gl
+class ThreadPool {
+public:
+  // zero workers is valid, every task then runs on the calling thread
+  explicit ThreadPool(
+      unsigned num_threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  unsigned get_num_threads() const { return workers.size(); }
+
+  // queues a task, use wait_idle to know when it has run
+  void submit(std::function<void()> task);
+
+  // blocks until the queue is empty and no worker is running a task
+  void wait_idle();
+
+  // calls task(first, last) on disjoint ranges covering [0, count) and
+  // returns once all of them are done, the calling thread takes one range
+  // itself, ranges are never smaller than min_range_size
+  void parallel_for(size_t count,
+                    const std::function<void(size_t, size_t)> &task,
+                    size_t min_range_size = 1024);
+
+private:
+  void worker_loop();
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable task_available;
+  std::condition_variable idle;
+  size_t num_running = 0;
+  bool stopping = false;
+};
+
+#endif // THREAD_POOL_HPP
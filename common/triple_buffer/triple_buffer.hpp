@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// hands the latest of a stream of values from one producer thread to one
+// consumer thread without locks: the producer always has a slot of its own to
+// write, the consumer a slot of its own to read, and the third slot holds the
+// most recently published value, swapping it with either side is a single
+// atomic exchange, a value the consumer never got to is overwritten by the
+// next publish, so neither side ever waits on the other
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  // producer only, the slot to fill before the next publish, it still holds
+  // whatever was written to it two publishes ago
+  T &get_write_slot() { return slots[write_index]; }
+
+  // producer only, makes the write slot the latest value and takes over the
+  // slot it replaces
+  void publish() {
+    uint8_t previous = shared.exchange(write_index | fresh_bit,
+                                       std::memory_order_acq_rel);
+    write_index = previous & index_mask;
+  }
+
+  // consumer only, moves to the latest value if one was published since the
+  // last call, returns false and keeps the current value otherwise
+  bool update() {
+    if ((shared.load(std::memory_order_relaxed) & fresh_bit) == 0)
+      return false;
+    uint8_t previous = shared.exchange(read_index, std::memory_order_acq_rel);
+    read_index = previous & index_mask;
+    return true;
+  }
+
+  // consumer only, stays valid and unchanged until the next update
+  const T &get_read_slot() const { return slots[read_index]; }
+
+private:
+  static constexpr uint8_t index_mask = 3;
+  // set while the shared slot holds a value the consumer has not taken yet
+  static constexpr uint8_t fresh_bit = 4;
+
+  std::array<T, 3> slots{};
+  // the index of the middle slot and the fresh bit, on a cache line of its
+  // own so that the two sides' private indices do not share it
+  alignas(64) std::atomic<uint8_t> shared{1};
+  alignas(64) uint8_t write_index = 0;
+  alignas(64) uint8_t read_index = 2;
+};
+
+#endif // TRIPLE_BUFFER_HPP
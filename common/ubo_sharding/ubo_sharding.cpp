@@ -0,0 +1,157 @@
+#include "ubo_sharding.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+bool compute_ubo_shard_layout(int num_objects, UboShardLayout &layout,
+                              GLsizeiptr object_size) {
+  GLint max_block_size, max_vertex_blocks, max_bindings, offset_alignment;
+  glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_block_size);
+  glGetIntegerv(GL_MAX_VERTEX_UNIFORM_BLOCKS, &max_vertex_blocks);
+  glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &max_bindings);
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+
+  // a shard of a multiple of granule objects always ends where the next one
+  // may legally start, and on a vec4 boundary
+  GLsizeiptr unit = std::lcm<GLsizeiptr>(std::max(offset_alignment, 1), 16);
+  int granule = unit / std::gcd(unit, object_size);
+  int max_objects_per_shard =
+      max_block_size / object_size / granule * granule;
+  int max_shards = std::min({max_vertex_blocks, max_bindings, max_ubo_shards});
+
+  // evenly sized shards keep the shader's index math to a single division
+  int num_shards =
+      (num_objects + max_objects_per_shard - 1) / max_objects_per_shard;
+  if (num_shards > max_shards) {
+    std::cerr << num_objects << " objects need " << num_shards
+              << " uniform blocks of " << max_block_size
+              << " bytes but only " << max_shards
+              << " can be bound to the vertex stage, at most "
+              << static_cast<long>(max_shards) * max_objects_per_shard
+              << " objects fit" << std::endl;
+    return false;
+  }
+
+  int objects_per_shard = (num_objects + num_shards - 1) / num_shards;
+  objects_per_shard = (objects_per_shard + granule - 1) / granule * granule;
+
+  layout.num_objects = num_objects;
+  layout.object_size = object_size;
+  layout.num_shards = num_shards;
+  layout.objects_per_shard = objects_per_shard;
+  layout.shard_stride = objects_per_shard * object_size;
+  layout.buffer_size = num_shards * layout.shard_stride;
+  return true;
+}
+
+// block arrays cannot be indexed with a per vertex value, so the shard is
+// chosen with a switch over constant indices, one case per possible shard
+const char *const ubo_shard_select_cases_glsl = R"(
+            SELECT(0)
+        #if NUM_SHARDS > 1
+            SELECT(1)
+        #endif
+        #if NUM_SHARDS > 2
+            SELECT(2)
+        #endif
+        #if NUM_SHARDS > 3
+            SELECT(3)
+        #endif
+        #if NUM_SHARDS > 4
+            SELECT(4)
+        #endif
+        #if NUM_SHARDS > 5
+            SELECT(5)
+        #endif
+        #if NUM_SHARDS > 6
+            SELECT(6)
+        #endif
+        #if NUM_SHARDS > 7
+            SELECT(7)
+        #endif
+        #if NUM_SHARDS > 8
+            SELECT(8)
+        #endif
+        #if NUM_SHARDS > 9
+            SELECT(9)
+        #endif
+        #if NUM_SHARDS > 10
+            SELECT(10)
+        #endif
+        #if NUM_SHARDS > 11
+            SELECT(11)
+        #endif
+        #if NUM_SHARDS > 12
+            SELECT(12)
+        #endif
+        #if NUM_SHARDS > 13
+            SELECT(13)
+        #endif
+        #if NUM_SHARDS > 14
+            SELECT(14)
+        #endif
+        #if NUM_SHARDS > 15
+            SELECT(15)
+        #endif
+    )";
+
+static const std::string ubo_shard_vertex_shader_source = std::string(R"(
+        #version 330 core
+        layout (location = 0) in vec3 position;
+        uniform mat4 projection;
+        uniform mat4 view;
+        layout(std140) uniform ModelMatrices {
+            mat4 matrices[OBJECTS_PER_SHARD];
+        } shards[NUM_SHARDS];
+
+        #define SELECT(k) case k: model = shards[k].matrices[localIndex]; break;
+
+        void main() {
+            int triangleIndex = gl_VertexID / 3;
+            int shard = triangleIndex / OBJECTS_PER_SHARD;
+            int localIndex = triangleIndex - shard * OBJECTS_PER_SHARD;
+            mat4 model;
+            switch (shard) {)") + ubo_shard_select_cases_glsl + R"(
+            }
+            gl_Position = projection * view * model * vec4(position, 1.0);
+        }
+    )";
+
+const char *const ubo_shard_vertex_shader_template =
+    ubo_shard_vertex_shader_source.c_str();
+
+ShaderDefines get_ubo_shard_defines(const UboShardLayout &layout) {
+  ShaderDefines defines;
+  defines.set("NUM_SHARDS", layout.num_shards)
+      .set("OBJECTS_PER_SHARD", layout.objects_per_shard);
+  return defines;
+}
+
+GLuint create_ubo_shard_buffer(const UboShardLayout &layout,
+                               const void *objects) {
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, layout.buffer_size, nullptr, GL_STATIC_DRAW);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, layout.num_objects * layout.object_size,
+                  objects);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return buffer;
+}
+
+void bind_ubo_shard_blocks(GLuint program, const UboShardLayout &layout) {
+  for (int shard = 0; shard < layout.num_shards; ++shard) {
+    std::string block_name = "ModelMatrices[" + std::to_string(shard) + "]";
+    GLuint block_index = glGetUniformBlockIndex(program, block_name.c_str());
+    glUniformBlockBinding(program, block_index, shard);
+  }
+}
+
+void bind_ubo_shard_ranges(GLuint buffer, const UboShardLayout &layout,
+                           GLintptr base_offset) {
+  for (int shard = 0; shard < layout.num_shards; ++shard)
+    glBindBufferRange(GL_UNIFORM_BUFFER, shard, buffer,
+                      base_offset + shard * layout.shard_stride,
+                      layout.shard_stride);
+}
@@ -0,0 +1,62 @@
+#ifndef UBO_SHARDING_HPP
+#define UBO_SHARDING_HPP
+
+#include <glad/glad.h>
+#include <string>
+
+#include "shader_variants/shader_variants.hpp"
+
+// the most shards ubo_shard_vertex_shader_template selects from, no
+// implementation we run on binds more blocks to the vertex stage
+// (GL_MAX_VERTEX_UNIFORM_BLOCKS is 12 to 16 in practice)
+constexpr int max_ubo_shards = 16;
+
+// how num_objects model matrices are split across uniform blocks, all shards
+// live back to back in one buffer so the matrices stay contiguous, shard i
+// starts at i * shard_stride and is bound to binding point i
+struct UboShardLayout {
+  int num_objects = 0;
+  // bytes per object, 64 for a mat4, compact encodings fit more objects into
+  // each block
+  GLsizeiptr object_size = 0;
+  int num_shards = 0;
+  // chosen so that every shard starts on a multiple of
+  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and holds whole vec4s
+  int objects_per_shard = 0;
+  GLsizeiptr shard_stride = 0;
+  // bytes the buffer needs so that the last shard is fully backed
+  GLsizeiptr buffer_size = 0;
+};
+
+// picks the smallest number of shards that fits num_objects objects of
+// object_size bytes given GL_MAX_UNIFORM_BLOCK_SIZE, and spreads the objects
+// evenly across them, returns false and logs when even
+// GL_MAX_VERTEX_UNIFORM_BLOCKS full blocks are not enough
+bool compute_ubo_shard_layout(int num_objects, UboShardLayout &layout,
+                              GLsizeiptr object_size = 16 * sizeof(GLfloat));
+
+// vertex shader for a layout of mat4s, built with get_ubo_shard_defines,
+// shard i is element i of the block array ModelMatrices, the object index is
+// gl_VertexID / 3 and the usual projection and view uniforms apply
+extern const char *const ubo_shard_vertex_shader_template;
+// the case labels of that template's switch (shard), SELECT(0) to
+// SELECT(NUM_SHARDS - 1), for templates over other shard contents that
+// define SELECT(k) themselves
+extern const char *const ubo_shard_select_cases_glsl;
+// NUM_SHARDS and OBJECTS_PER_SHARD
+ShaderDefines get_ubo_shard_defines(const UboShardLayout &layout);
+
+// creates the buffer holding every shard and uploads the objects' data
+// (object_size bytes each) into it
+GLuint create_ubo_shard_buffer(const UboShardLayout &layout,
+                               const void *objects);
+
+// points block ModelMatrices[i] of program at binding point i
+void bind_ubo_shard_blocks(GLuint program, const UboShardLayout &layout);
+
+// binds every shard range of buffer to its binding point, base_offset is where
+// the first shard starts and must itself be suitably aligned
+void bind_ubo_shard_ranges(GLuint buffer, const UboShardLayout &layout,
+                           GLintptr base_offset = 0);
+
+#endif // UBO_SHARDING_HPP
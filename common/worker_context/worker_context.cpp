@@ -0,0 +1,112 @@
+#include "worker_context.hpp"
+
+#include <iostream>
+#include <utility>
+
+WorkerContext::WorkerContext(OffscreenContext &offscreen)
+    : offscreen(&offscreen) {}
+
+WorkerContext::WorkerContext(GLFWwindow *window) : share_window(window) {}
+
+WorkerContext::~WorkerContext() {
+  if (worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    task_available.notify_all();
+    worker.join();
+  }
+  if (offscreen != nullptr)
+    offscreen->destroy_shared_context(egl_context, egl_surface);
+  if (hidden_window != nullptr)
+    glfwDestroyWindow(hidden_window);
+}
+
+bool WorkerContext::initialize() {
+  if (offscreen != nullptr) {
+    if (!offscreen->create_shared_context(egl_context, egl_surface))
+      return false;
+  } else {
+    // the window hints in effect are the ones the shared window was created
+    // with, only the visibility changes
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    hidden_window = glfwCreateWindow(1, 1, "worker", nullptr, share_window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (hidden_window == nullptr) {
+      std::cerr << "Failed to create a shared GLFW context" << std::endl;
+      return false;
+    }
+  }
+
+  std::promise<bool> started;
+  std::future<bool> started_result = started.get_future();
+  worker = std::thread(&WorkerContext::worker_loop, this, std::move(started));
+  if (!started_result.get()) {
+    worker.join();
+    std::cerr << "Failed to make the worker context current" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool WorkerContext::make_current() {
+  if (offscreen != nullptr)
+    return offscreen->make_shared_context_current(egl_context, egl_surface);
+  glfwMakeContextCurrent(hidden_window);
+  return glfwGetCurrentContext() == hidden_window;
+}
+
+void WorkerContext::release_current() {
+  if (offscreen != nullptr)
+    offscreen->make_shared_context_current(EGL_NO_CONTEXT, EGL_NO_SURFACE);
+  else
+    glfwMakeContextCurrent(nullptr);
+}
+
+void WorkerContext::worker_loop(std::promise<bool> started) {
+  if (!make_current()) {
+    started.set_value(false);
+    return;
+  }
+  started.set_value(true);
+
+  while (true) {
+    std::packaged_task<GLsync()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_available.wait(lock, [&] { return stopping || !tasks.empty(); });
+      if (tasks.empty())
+        break;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+
+  // a context may only be destroyed once no thread has it current
+  release_current();
+}
+
+std::future<GLsync> WorkerContext::submit(std::function<void()> task) {
+  std::packaged_task<GLsync()> fenced_task([task = std::move(task)] {
+    task();
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // without the flush the fence may never reach the gpu and a wait on it
+    // from another context would never return
+    glFlush();
+    return fence;
+  });
+  std::future<GLsync> fence = fenced_task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(fenced_task));
+  }
+  task_available.notify_one();
+  return fence;
+}
+
+void wait_for_worker_fence(GLsync fence) {
+  glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+  glDeleteSync(fence);
+}
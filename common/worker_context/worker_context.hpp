@@ -0,0 +1,65 @@
+#ifndef WORKER_CONTEXT_HPP
+#define WORKER_CONTEXT_HPP
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <EGL/egl.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "offscreen_context/offscreen_context.hpp"
+
+// a thread with a gl context of its own that shares buffers, textures and
+// programs (but not vertex arrays or framebuffers) with the main context, for
+// uploading and compiling off the main thread, every task ends with a fence
+// that the main context waits on before it touches what the task wrote
+class WorkerContext {
+public:
+  // shares with a headless context, through a second egl context
+  explicit WorkerContext(OffscreenContext &offscreen);
+  // shares with window's context, through a hidden window since that is the
+  // only way glfw creates a context
+  explicit WorkerContext(GLFWwindow *window);
+  ~WorkerContext();
+
+  WorkerContext(const WorkerContext &) = delete;
+  WorkerContext &operator=(const WorkerContext &) = delete;
+
+  // creates the context on the calling thread, which for glfw must be the
+  // main thread, and starts the worker with it current, returns false and
+  // logs the reason on failure
+  bool initialize();
+
+  // runs task on the worker thread, then inserts a fence and flushes it, the
+  // future yields the fence, the caller waits on it (glWaitSync) before using
+  // what the task wrote and deletes it
+  std::future<GLsync> submit(std::function<void()> task);
+
+private:
+  bool make_current();
+  void release_current();
+  void worker_loop(std::promise<bool> started);
+
+  OffscreenContext *offscreen = nullptr;
+  EGLContext egl_context = EGL_NO_CONTEXT;
+  EGLSurface egl_surface = EGL_NO_SURFACE;
+  GLFWwindow *share_window = nullptr;
+  GLFWwindow *hidden_window = nullptr;
+
+  std::thread worker;
+  std::deque<std::packaged_task<GLsync()>> tasks;
+  std::mutex mutex;
+  std::condition_variable task_available;
+  bool stopping = false;
+};
+
+// makes the current context's gpu work wait for a fence inserted in another
+// context, such as one from WorkerContext::submit, and deletes it, the calling
+// thread does not block
+void wait_for_worker_fence(GLsync fence);
+
+#endif // WORKER_CONTEXT_HPP
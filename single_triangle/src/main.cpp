@@ -1,6 +1,11 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <memory>
+
+#include "draw_statistics/draw_statistics.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "offscreen_context/offscreen_context.hpp"
 
 // Vertex data for a simple triangle
 float vertices[] = {
@@ -30,33 +35,52 @@ const char *fragmentShaderSource = R"(
     }
 )";
 
-int main() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW!" << std::endl;
+int main(int argc, char *argv[]) {
+    HeadlessOptions headless;
+    FrameTimerOptions timer_options;
+    if (!parse_headless_options(argc, argv, headless) || !parse_frame_timer_options(argc, argv, timer_options)) {
         return -1;
     }
-
-    // Set OpenGL version to 3.3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow *window = glfwCreateWindow(800, 600, "OpenGL 3.3 Triangle", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window!" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Make the OpenGL context current
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(0); // Enable vsync
-
-    // Load GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD!" << std::endl;
-        return -1;
+    if (headless.enabled)
+        clamp_warmup_frames(timer_options, headless.num_frames);
+
+    GLFWwindow *window = nullptr;
+    OffscreenContext offscreen(800, 600, 3, 3);
+
+    if (headless.enabled) {
+        // Render into an offscreen framebuffer, no display required
+        if (!offscreen.initialize()) {
+            std::cerr << "Failed to create offscreen context!" << std::endl;
+            return -1;
+        }
+    } else {
+        // Initialize GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW!" << std::endl;
+            return -1;
+        }
+
+        // Set OpenGL version to 3.3
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+        // Create a windowed mode window and its OpenGL context
+        window = glfwCreateWindow(800, 600, "OpenGL 3.3 Triangle", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window!" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        // Make the OpenGL context current
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0); // Enable vsync
+
+        // Load GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD!" << std::endl;
+            return -1;
+        }
     }
 
     // Compile shaders
@@ -121,30 +145,58 @@ int main() {
     // Draw the triangle
     glBindVertexArray(VAO);
 
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
+    // Main loop, headless runs stop after a fixed number of frames
+    int frame = 0;
+    FrameTimer frame_timer(timer_options.warmup_frames);
+    std::unique_ptr<DrawStatistics> draw_statistics;
+    if (timer_options.draw_statistics)
+        draw_statistics = std::make_unique<DrawStatistics>();
+    while (headless.enabled ? frame < headless.num_frames : !glfwWindowShouldClose(window)) {
+        frame_timer.begin_frame();
+
         // Process input
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        if (!headless.enabled && glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
 
         // Render
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Clear background with dark color
         glClear(GL_COLOR_BUFFER_BIT);
 
+        if (draw_statistics)
+            draw_statistics->begin(frame_timer);
         glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (draw_statistics)
+            draw_statistics->end();
 
         // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (headless.enabled) {
+            offscreen.present();
+        } else {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        frame_timer.end_frame();
+        ++frame;
     }
 
+    // Report frame times
+    if (draw_statistics)
+        draw_statistics->finish();
+    frame_timer.finish();
+    frame_timer.print_summary(std::cout, "single_triangle");
+    if (!timer_options.output_path.empty())
+        frame_timer.write_results(timer_options.output_path, "single_triangle");
+
     // Clean up
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
 
     // Terminate GLFW
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (!headless.enabled) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
@@ -3,7 +3,17 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "dirty_tracker/dirty_tracker.hpp"
+#include "draw_statistics/draw_statistics.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "offscreen_context/offscreen_context.hpp"
 
 const int numTriangles = 100;
 
@@ -50,28 +60,63 @@ GLuint CreateShaderProgram(const char *vertexSource, const char *fragmentSource)
     return program;
 }
 
-int main() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
+int main(int argc, char *argv[]) {
+    HeadlessOptions headless;
+    FrameTimerOptions timer_options;
+    if (!parse_headless_options(argc, argv, headless) || !parse_frame_timer_options(argc, argv, timer_options)) {
         return -1;
     }
-
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow *window = glfwCreateWindow(800, 600, "transform as uniform variable", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    if (headless.enabled)
+        clamp_warmup_frames(timer_options, headless.num_frames);
+
+    // Percentage of the triangles that move every frame, only their matrices are uploaded again
+    float movingPercent = 0.0f;
+    bool trackChanges = argc == 3 && std::string(argv[1]) == "--moving";
+    if (trackChanges) {
+        movingPercent = std::atof(argv[2]);
+    } else if (argc != 1) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--moving <percent>] [--headless] [--frames <num_frames>] [--warmup <num_frames>]"
+                     " [--output <results.json|csv>] [--draw-stats]\n";
+        return -1;
+    }
+    if (movingPercent < 0.0f || movingPercent > 100.0f) {
+        std::cerr << "Error: --moving must be between 0 and 100.\n";
         return -1;
     }
 
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(0); 
+    GLFWwindow *window = nullptr;
+    OffscreenContext offscreen(800, 600, 3, 3);
 
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    if (headless.enabled) {
+        // Render into an offscreen framebuffer, no display required
+        if (!offscreen.initialize()) {
+            std::cerr << "Failed to create offscreen context" << std::endl;
+            return -1;
+        }
+    } else {
+        // Initialize GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
+
+        // Create a windowed mode window and its OpenGL context
+        window = glfwCreateWindow(800, 600, "transform as uniform variable", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0); 
+
+        // Initialize GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
     }
 
     // Set up vertex data and buffers for 100 triangles
@@ -154,33 +199,105 @@ int main() {
     glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
 
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
+    // Every element of the array has a location of its own, a range of elements is set starting from the
+    // location of its first one
+    GLint modelMatrixLocs[numTriangles];
+    for (int i = 0; i < numTriangles; ++i)
+        modelMatrixLocs[i] = glGetUniformLocation(shaderProgram, ("modelMatrices[" + std::to_string(i) + "]").c_str());
+
+    // The moving triangles are spread evenly over the array, each circles around the origin from its place
+    std::vector<int> movingTriangles;
+    int numMoving = static_cast<int>(numTriangles * movingPercent / 100.0f + 0.5f);
+    for (int i = 0; i < numTriangles; ++i)
+        if ((i + 1) * numMoving / numTriangles != i * numMoving / numTriangles)
+            movingTriangles.push_back(i);
+
+    // Only the matrices that changed since the last upload are set again, the first frame sets all of them
+    DirtyTracker dirtyMatrices(numTriangles);
+    for (int i = 0; i < numTriangles; ++i)
+        dirtyMatrices.mark(i);
+    std::vector<DirtyRange> dirtyRanges;
+
+    // Main loop, headless runs stop after a fixed number of frames
+    int frame = 0;
+    FrameTimer frame_timer(timer_options.warmup_frames);
+    std::unique_ptr<DrawStatistics> draw_statistics;
+    if (timer_options.draw_statistics)
+        draw_statistics = std::make_unique<DrawStatistics>();
+    while (headless.enabled ? frame < headless.num_frames : !glfwWindowShouldClose(window)) {
+        frame_timer.begin_frame();
+
         // Process input
-        glfwPollEvents();
+        if (!headless.enabled)
+            glfwPollEvents();
 
         // Clear the screen
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        GLint modelMatricesLoc = glGetUniformLocation(shaderProgram, "modelMatrices");
+        float time = headless.enabled ? frame / 60.0f : glfwGetTime();
+        for (int i : movingTriangles) {
+            float angle = 2.0f * M_PI * i / numTriangles + 0.5f * time;
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(cos(angle), sin(angle), 0.0f));
+            model = glm::scale(model, glm::vec3(0.3f));
+            modelMatrices[i] = model;
+            dirtyMatrices.mark(i);
+        }
 
-        glUniformMatrix4fv(modelMatricesLoc, numTriangles, GL_FALSE, glm::value_ptr(modelMatrices[0]));
+        // Ranges a few unchanged matrices apart are set in one call
+        dirtyRanges.clear();
+        dirtyMatrices.collect_ranges(dirtyRanges, 4);
+        dirtyMatrices.clear();
+        size_t uploadedBytes = 0;
+        for (const DirtyRange &range : dirtyRanges) {
+            glUniformMatrix4fv(modelMatrixLocs[range.first], range.count, GL_FALSE,
+                               glm::value_ptr(modelMatrices[range.first]));
+            uploadedBytes += range.count * sizeof(glm::mat4);
+        }
+        frame_timer.record("uploaded_bytes", uploadedBytes);
+        frame_timer.record("upload_ranges", dirtyRanges.size());
 
         // Draw the triangles
+        if (draw_statistics)
+            draw_statistics->begin(frame_timer);
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 3 * numTriangles); // Draw 100 triangles
+        if (draw_statistics)
+            draw_statistics->end();
         glBindVertexArray(0);
 
         // Swap buffers
-        glfwSwapBuffers(window);
+        if (headless.enabled)
+            offscreen.present();
+        else
+            glfwSwapBuffers(window);
+
+        frame_timer.end_frame();
+        ++frame;
     }
 
+    // Report frame times
+    if (draw_statistics)
+        draw_statistics->finish();
+    frame_timer.finish();
+    std::string runName = "transform_as_uniform_variable";
+    // Named like the driver's runs, by the percentage rather than the count, so results from both line up
+    if (trackChanges) {
+        std::ostringstream percent;
+        percent << movingPercent;
+        runName += "_moving_" + percent.str();
+    }
+    frame_timer.print_summary(std::cout, runName);
+    if (!timer_options.output_path.empty())
+        frame_timer.write_results(timer_options.output_path, runName);
+
     // Clean up
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
 
-    glfwTerminate();
+    if (!headless.enabled)
+        glfwTerminate();
     return 0;
 }
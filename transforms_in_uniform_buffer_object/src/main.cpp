@@ -4,56 +4,29 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <chrono>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "arena/arena.hpp"
+#include "draw_statistics/draw_statistics.hpp"
+#include "frame_capture/frame_capture.hpp"
+#include "frame_timer/frame_timer.hpp"
+#include "offscreen_context/offscreen_context.hpp"
+#include "program_cache/program_cache.hpp"
+#include "shader_utils/shader_utils.hpp"
+#include "shader_variants/shader_variants.hpp"
+#include "ubo_sharding/ubo_sharding.hpp"
+#include "worker_context/worker_context.hpp"
 // clang-format on
 
 int window_width = 1920;
 int window_height = 1080;
 
-// TODO: next we have to make the number of ubos variable to do further testing
-
-// Function to compile shaders
-GLuint compile_shader(const char *source, GLenum type) {
-  GLuint shader = glCreateShader(type);
-  glShaderSource(shader, 1, &source, nullptr);
-  glCompileShader(shader);
-
-  GLint success;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    char infoLog[512];
-    glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-    std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-  }
-  return shader;
-}
-
-// Function to create the shader program
-GLuint create_shader_program(const char *vertex_source,
-                             const char *fragment_source) {
-
-  GLuint vertex_shader = compile_shader(vertex_source, GL_VERTEX_SHADER);
-  GLuint fragment_shader = compile_shader(fragment_source, GL_FRAGMENT_SHADER);
-
-  GLuint program = glCreateProgram();
-  glAttachShader(program, vertex_shader);
-  glAttachShader(program, fragment_shader);
-  glLinkProgram(program);
-
-  GLint success;
-  glGetProgramiv(program, GL_LINK_STATUS, &success);
-  if (!success) {
-    char infoLog[512];
-    glGetProgramInfoLog(program, 512, nullptr, infoLog);
-    std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-  }
-
-  glDeleteShader(vertex_shader);
-  glDeleteShader(fragment_shader);
-
-  return program;
-}
-
 void generate_model_matrices(glm::mat4 *model_matrices, int num_objects,
                              glm::vec3 origin) {
   // Calculate grid size for a perfect cube
@@ -86,9 +59,67 @@ void generate_model_matrices(glm::mat4 *model_matrices, int num_objects,
   }
 }
 
+struct UploadOptions {
+  // shared contexts the buffer uploads and the shader compile are spread
+  // across, 0 does everything on the main context
+  int num_worker_contexts = 0;
+  // uploads every matrix again every this many frames, 0 never does
+  int reupload_interval = 0;
+};
+
+// consumes --upload-contexts <n> and --reupload <frames> like the shared
+// option parsers
+static bool parse_upload_options(int &argc, char *argv[],
+                                 UploadOptions &options) {
+  int write_index = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--upload-contexts" || arg == "--reupload") {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: " << arg << " requires a value.\n";
+        return false;
+      }
+      int value = std::atoi(argv[++i]);
+      if (value < 0) {
+        std::cerr << "Error: " << arg << " must not be negative.\n";
+        return false;
+      }
+      if (arg == "--upload-contexts")
+        options.num_worker_contexts = value;
+      else
+        options.reupload_interval = value;
+    } else {
+      argv[write_index++] = argv[i];
+    }
+  }
+  argc = write_index;
+  argv[argc] = nullptr;
+  return true;
+}
+
 int main(int argc, char *argv[]) {
+  HeadlessOptions headless;
+  FrameTimerOptions timer_options;
+  ProgramCacheOptions program_cache;
+  UploadOptions upload;
+  FrameCaptureOptions capture_options;
+  if (!parse_headless_options(argc, argv, headless) ||
+      !parse_frame_timer_options(argc, argv, timer_options) ||
+      !parse_program_cache_options(argc, argv, program_cache) ||
+      !parse_upload_options(argc, argv, upload) ||
+      !parse_frame_capture_options(argc, argv, capture_options))
+    return 1;
+  if (headless.enabled)
+    clamp_warmup_frames(timer_options, headless.num_frames);
+
   if (argc != 2) {
-    std::cerr << "Usage: " << argv[0] << " <num_objects>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <num_objects> [--headless] [--frames <num_frames>]"
+                 " [--warmup <num_frames>] [--output <results.json|csv>]"
+                 " [--draw-stats] [--program-cache <dir>]"
+                 " [--upload-contexts <n>] [--reupload <frames>]"
+                 " [--fixed-timestep] [--capture <dir>]"
+                 " [--capture-every <frames>]\n";
     return 1;
   }
 
@@ -99,41 +130,84 @@ int main(int argc, char *argv[]) {
   }
 
   int total_num_objects = num_objects * 4;
+  set_program_cache_directory(program_cache.directory);
 
   std::cout << "Number of objects: " << num_objects << '\n';
 
-  GLuint VAO, VBO, shader_program, UBO_0, UBO_1, UBO_2, UBO_3;
-  GLfloat triangle_vertices[total_num_objects * 9]; // 3 vertices per triangle,
-                                                    // 9 components per triangle
-
-  // Initialize GLFW
-  if (!glfwInit()) {
-    std::cerr << "Failed to initialize GLFW" << std::endl;
-    return -1;
-  }
+  GLuint VAO, VBO, shader_program, UBO;
+
+  // One aligned block for all per-object CPU data; 9 floats per triangle plus
+  // one model matrix per object
+  Arena arena(Arena::footprint<GLfloat>(total_num_objects * 9) +
+              Arena::footprint<glm::mat4>(total_num_objects));
+  std::span<GLfloat> triangle_vertices =
+      arena.allocate<GLfloat>(total_num_objects * 9);
+
+  // Startup costs are reported on their own, in milliseconds
+  auto milliseconds_since = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  auto context_start = std::chrono::steady_clock::now();
+
+  GLFWwindow *window = nullptr;
+  OffscreenContext offscreen(window_width, window_height, 3, 3);
+
+  if (headless.enabled) {
+    // Render into an offscreen framebuffer, no display required
+    if (!offscreen.initialize()) {
+      std::cerr << "Failed to create offscreen context" << std::endl;
+      return -1;
+    }
+  } else {
+    // Initialize GLFW
+    if (!glfwInit()) {
+      std::cerr << "Failed to initialize GLFW" << std::endl;
+      return -1;
+    }
 
-  // Create a windowed mode window and its OpenGL context
-  GLFWwindow *window =
-      glfwCreateWindow(window_width, window_height,
-                       "transforms in uniform buffer", nullptr, nullptr);
-  if (!window) {
-    std::cerr << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
-    return -1;
-  }
+    // Create a windowed mode window and its OpenGL context
+    window = glfwCreateWindow(window_width, window_height,
+                              "transforms in uniform buffer", nullptr, nullptr);
+    if (!window) {
+      std::cerr << "Failed to create GLFW window" << std::endl;
+      glfwTerminate();
+      return -1;
+    }
 
-  glfwMakeContextCurrent(window);
-  glfwSwapInterval(0);
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
 
-  // Initialize GLAD
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-    std::cerr << "Failed to initialize GLAD" << std::endl;
-    return -1;
+    // Initialize GLAD
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      std::cerr << "Failed to initialize GLAD" << std::endl;
+      return -1;
+    }
   }
 
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  glBindVertexArray(VAO);
+  double context_ms = milliseconds_since(context_start);
+  auto setup_start = std::chrono::steady_clock::now();
+
+  // Buffer uploads and the shader compile run either right here or on shared
+  // worker contexts, one task each, the main context waits on every task's
+  // fence before it uses what the task created
+  std::vector<std::unique_ptr<WorkerContext>> workers;
+  for (int i = 0; i < upload.num_worker_contexts; ++i) {
+    workers.push_back(headless.enabled
+                          ? std::make_unique<WorkerContext>(offscreen)
+                          : std::make_unique<WorkerContext>(window));
+    if (!workers.back()->initialize())
+      return -1;
+  }
+  std::vector<std::future<GLsync>> handoffs;
+  auto run_setup_task = [&](std::function<void()> task) {
+    if (workers.empty())
+      task();
+    else
+      handoffs.push_back(
+          workers[handoffs.size() % workers.size()]->submit(std::move(task)));
+  };
 
   for (int i = 0; i < total_num_objects; ++i) {
     // Define a small triangle centered at (0, 0)
@@ -151,75 +225,21 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(triangle_vertices), triangle_vertices,
-               GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
-                        (GLvoid *)0);
-  glEnableVertexAttribArray(0);
-
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  run_setup_task([&] {
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, triangle_vertices.size_bytes(),
+                 triangle_vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  });
+
+  // Split the objects across as many uniform blocks as the hardware needs
+  UboShardLayout shard_layout;
+  if (!compute_ubo_shard_layout(total_num_objects, shard_layout))
+    return 1;
 
-  std::string shader_code =
-      "#version 330 core\n"
-
-      "layout (location = 0) in vec3 position;\n"
-      "uniform mat4 projection;\n"
-      "uniform mat4 view;\n"
-
-      "uniform float camera_rotation_angle;\n"
-
-      "layout(std140) uniform ModelMatrices0 {\n"
-      "    mat4 modelMatrices0[" +
-      std::to_string(num_objects) +
-      "];\n"
-      "};\n"
-      "layout(std140) uniform ModelMatrices1 {\n"
-      "    mat4 modelMatrices1[" +
-      std::to_string(num_objects) +
-      "];\n"
-      "};\n"
-      "layout(std140) uniform ModelMatrices2 {\n"
-      "    mat4 modelMatrices2[" +
-      std::to_string(num_objects) +
-      "];\n"
-      "};\n"
-      "layout(std140) uniform ModelMatrices3 {\n"
-      "    mat4 modelMatrices3[" +
-      std::to_string(num_objects) +
-      "];\n"
-      "};\n"
-
-      "void main() {\n"
-      "    int triangleIndex = gl_VertexID / 3;\n"
-      "    mat4 model;\n"
-      "    if (triangleIndex < " +
-      std::to_string(num_objects) +
-      ") {\n"
-      "        model = modelMatrices0[triangleIndex];\n"
-      "    } else if (triangleIndex < 2 * " +
-      std::to_string(num_objects) +
-      ") {\n"
-      "        model = modelMatrices1[triangleIndex - " +
-      std::to_string(num_objects) +
-      "];\n"
-      "    } else if (triangleIndex < 3 * " +
-      std::to_string(num_objects) +
-      ") {\n"
-      "        model = modelMatrices2[triangleIndex - 2 * " +
-      std::to_string(num_objects) +
-      "];\n"
-      "    } else {\n"
-      "        model = modelMatrices3[triangleIndex - 3 * " +
-      std::to_string(num_objects) +
-      "];\n"
-      "    }\n"
-      "    gl_Position = projection * view * model * vec4(position, 1.0);\n"
-      "}";
-
-  const char *vertex_shader_source = shader_code.c_str();
+  std::cout << "Uniform blocks: " << shard_layout.num_shards << " of "
+            << shard_layout.objects_per_shard << " matrices\n";
 
   const char *fragmentShaderSource = R"(
         #version 330 core
@@ -229,14 +249,22 @@ int main(int argc, char *argv[]) {
         }
     )";
 
-  // Create shader program
-  shader_program =
-      create_shader_program(vertex_shader_source, fragmentShaderSource);
-
-  glm::mat4 model_matrices0[num_objects];
-  glm::mat4 model_matrices1[num_objects];
-  glm::mat4 model_matrices2[num_objects];
-  glm::mat4 model_matrices3[num_objects];
+  // Create shader program, the one variant of the shard template this run
+  // needs
+  ShaderTemplate shard_template = {
+      "ubo_shards", ubo_shard_vertex_shader_template, fragmentShaderSource};
+  ShaderVariantSet shader_variants;
+  size_t shard_variant = shader_variants.add(
+      shard_template, get_ubo_shard_defines(shard_layout));
+  run_setup_task([&] {
+    shader_program = shader_variants.build()
+                         ? shader_variants.get_program(shard_variant)
+                         : 0;
+  });
+
+  // The four cubes are stored back to back, cube i starts at i * num_objects
+  std::span<glm::mat4> model_matrices =
+      arena.allocate<glm::mat4>(total_num_objects);
 
   // Define a margin to space out the cubes
   float margin = 0.5f; // Adjust this value as needed for the desired spacing
@@ -244,64 +272,62 @@ int main(int argc, char *argv[]) {
   // Generate matrices for the first cube, starting from the top-right (1, 1,
   // -1)
   glm::vec3 origin0(1.0f + margin, 1.0f + margin, -1.0f);
-  generate_model_matrices(model_matrices0, num_objects, origin0);
+  generate_model_matrices(&model_matrices[0], num_objects, origin0);
 
   // Generate matrices for the second cube, starting from the top-left (-1, 1,
   // -1)
   glm::vec3 origin1(-1.0f - margin, 1.0f + margin, -1.0f);
-  generate_model_matrices(model_matrices1, num_objects, origin1);
+  generate_model_matrices(&model_matrices[num_objects], num_objects, origin1);
 
   // Generate matrices for the third cube, starting from the bottom-left (-1,
   // -1, -1)
   glm::vec3 origin2(-1.0f - margin, -1.0f - margin, -1.0f);
-  generate_model_matrices(model_matrices2, num_objects, origin2);
+  generate_model_matrices(&model_matrices[2 * num_objects], num_objects,
+                          origin2);
 
   // Generate matrices for the fourth cube, starting from the bottom-right (1,
   // -1, -1)
   glm::vec3 origin3(1.0f + margin, -1.0f - margin, -1.0f);
-  generate_model_matrices(model_matrices3, num_objects, origin3);
-
-  // Create and bind the UBO
-  glGenBuffers(1, &UBO_0);
-  glBindBuffer(GL_UNIFORM_BUFFER, UBO_0);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(model_matrices0), model_matrices0,
-               GL_STATIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, UBO_0); // Bind to binding point 0
-
-  glGenBuffers(1, &UBO_1);
-  glBindBuffer(GL_UNIFORM_BUFFER, UBO_1);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(model_matrices1), model_matrices1,
-               GL_STATIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 1, UBO_1); // Bind to binding point 1
-
-  glGenBuffers(2, &UBO_2);
-  glBindBuffer(GL_UNIFORM_BUFFER, UBO_2);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(model_matrices2), model_matrices2,
-               GL_STATIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 2, UBO_2); // Bind to binding point 2
-
-  glGenBuffers(3, &UBO_3);
-  glBindBuffer(GL_UNIFORM_BUFFER, UBO_3);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(model_matrices3), model_matrices3,
-               GL_STATIC_DRAW);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 3, UBO_3); // Bind to binding point 3
+  generate_model_matrices(&model_matrices[3 * num_objects], num_objects,
+                          origin3);
+
+  // Create the UBO holding every shard, reuploads through worker contexts
+  // write into a second one while the first is drawn from
+  run_setup_task([&] {
+    UBO = create_ubo_shard_buffer(shard_layout,
+                                  glm::value_ptr(model_matrices[0]));
+  });
+  GLuint back_UBO = 0;
+  bool double_buffered = !workers.empty() && upload.reupload_interval > 0;
+  if (double_buffered)
+    run_setup_task([&] {
+      back_UBO = create_ubo_shard_buffer(shard_layout,
+                                         glm::value_ptr(model_matrices[0]));
+    });
+
+  // Vertex arrays are not shared between contexts, so this one is built here
+  // once the vertex buffer is ready
+  glGenVertexArrays(1, &VAO);
+  for (std::future<GLsync> &handoff : handoffs)
+    wait_for_worker_fence(handoff.get());
+  if (shader_program == 0)
+    return 1;
+
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                        (GLvoid *)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  // Bind each shard to its binding point
+  bind_ubo_shard_ranges(UBO, shard_layout);
 
   // Use the shader program
   glUseProgram(shader_program);
 
-  GLuint block_index_0 =
-      glGetUniformBlockIndex(shader_program, "ModelMatrices0");
-  GLuint block_index_1 =
-      glGetUniformBlockIndex(shader_program, "ModelMatrices1");
-  GLuint block_index_2 =
-      glGetUniformBlockIndex(shader_program, "ModelMatrices2");
-  GLuint block_index_3 =
-      glGetUniformBlockIndex(shader_program, "ModelMatrices3");
-
-  glUniformBlockBinding(shader_program, block_index_0, 0);
-  glUniformBlockBinding(shader_program, block_index_1, 1);
-  glUniformBlockBinding(shader_program, block_index_2, 2);
-  glUniformBlockBinding(shader_program, block_index_3, 3);
+  bind_ubo_shard_blocks(shader_program, shard_layout);
 
   // Set the projection and view matrices
   glm::mat4 projection = glm::perspective(
@@ -314,23 +340,57 @@ int main(int argc, char *argv[]) {
 
   glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
   glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+  double setup_ms = milliseconds_since(setup_start);
 
   bool paused = false;
 
-  // Main loop
-  while (!glfwWindowShouldClose(window)) {
+  // Reuploads on the main context write the buffer being drawn from and
+  // leave synchronizing with the gpu to the driver, through a worker they go
+  // to the back buffer and are swapped in once their fence has been waited on
+  std::future<GLsync> reupload;
+  int reupload_frame = 0;
+  auto upload_matrices = [&](GLuint buffer) {
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, model_matrices.size_bytes(),
+                    model_matrices.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  };
+
+  // Main loop, headless runs stop after a fixed number of frames, they and
+  // runs with a fixed timestep drive the camera from the frame index so every
+  // run renders the same frames
+  bool fixed_clock = headless.enabled || capture_options.fixed_timestep;
+  int frame = 0;
+  FrameTimer frame_timer(timer_options.warmup_frames);
+  std::unique_ptr<DrawStatistics> draw_statistics;
+  if (timer_options.draw_statistics)
+    draw_statistics = std::make_unique<DrawStatistics>();
+  std::unique_ptr<FrameCapture> frame_capture;
+  if (!capture_options.directory.empty()) {
+    frame_capture = std::make_unique<FrameCapture>(
+        capture_options, window_width, window_height);
+    if (!frame_capture->initialize())
+      return 1;
+  }
+  while (headless.enabled ? frame < headless.num_frames
+                          : !glfwWindowShouldClose(window)) {
+    auto frame_start = std::chrono::steady_clock::now();
+    frame_timer.begin_frame();
+
     // Process input
-    glfwPollEvents();
+    if (!headless.enabled) {
+      glfwPollEvents();
 
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-      paused = !paused; // Toggle paused state
-      while (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        glfwPollEvents(); // Prevent multiple toggles while holding spacebar
+      if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+        paused = !paused; // Toggle paused state
+        while (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+          glfwPollEvents(); // Prevent multiple toggles while holding spacebar
+        }
       }
     }
 
     float radius = 8.0f; // Distance from the origin
-    float time = glfwGetTime();
+    float time = fixed_clock ? frame / 60.0f : glfwGetTime();
     float cam_x = cos(time) * radius;
     float cam_z = sin(time) * radius;
     glm::vec3 camera_position = glm::vec3(cam_x, 1.0f, cam_z);
@@ -342,25 +402,116 @@ int main(int argc, char *argv[]) {
     if (not paused)
       glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
 
+    // The matrices do not change, the upload itself is what is measured
+    if (upload.reupload_interval > 0) {
+      auto upload_start = std::chrono::steady_clock::now();
+      bool uploaded = false;
+      if (!double_buffered) {
+        if (frame % upload.reupload_interval == 0) {
+          upload_matrices(UBO);
+          uploaded = true;
+        }
+      } else {
+        if (reupload.valid() &&
+            reupload.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready) {
+          wait_for_worker_fence(reupload.get());
+          std::swap(UBO, back_UBO);
+          bind_ubo_shard_ranges(UBO, shard_layout);
+          frame_timer.record("reupload_frames", frame - reupload_frame);
+          uploaded = true;
+        }
+        if (frame % upload.reupload_interval == 0 && !reupload.valid()) {
+          // the back buffer was drawn from until the last swap, the worker
+          // waits for those draws before overwriting it
+          GLsync released = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+          glFlush();
+          reupload = workers[0]->submit([&, released, buffer = back_UBO] {
+            wait_for_worker_fence(released);
+            upload_matrices(buffer);
+          });
+          reupload_frame = frame;
+          uploaded = true;
+        }
+      }
+      if (uploaded)
+        frame_timer.record("upload_ms", milliseconds_since(upload_start));
+    }
+
     // Clear the screen
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Draw the triangles
     glBindVertexArray(VAO);
+    if (draw_statistics)
+      draw_statistics->begin(frame_timer);
     glDrawArrays(GL_TRIANGLES, 0, 3 * total_num_objects);
+    if (draw_statistics)
+      draw_statistics->end();
     glBindVertexArray(0);
 
+    if (frame_capture) {
+      auto capture_start = std::chrono::steady_clock::now();
+      frame_capture->capture(frame);
+      frame_timer.record("capture_ms", milliseconds_since(capture_start));
+    }
+
     // Swap buffers
-    glfwSwapBuffers(window);
+    if (headless.enabled)
+      offscreen.present();
+    else
+      glfwSwapBuffers(window);
+
+    frame_timer.end_frame();
+    if (frame == 0) {
+      const ProgramBuildStats &build_stats = get_program_build_stats();
+      std::cout << std::fixed << std::setprecision(3) << "Startup: context "
+                << context_ms << " ms, setup " << setup_ms << " ms ("
+                << upload.num_worker_contexts << " upload contexts), compile "
+                << build_stats.compile_ms
+                << " ms, link " << build_stats.link_ms << " ms, cache load "
+                << build_stats.cache_load_ms << " ms ("
+                << build_stats.programs_loaded << " from cache), first frame "
+                << milliseconds_since(frame_start) << " ms\n";
+      std::cout.unsetf(std::ios_base::floatfield);
+      shader_variants.print_stats(std::cout);
+    }
+    ++frame;
   }
 
-  // Clean up
+  // Report frame times
+  std::string run_name = "transforms_in_uniform_buffer_object_" +
+                         std::to_string(num_objects);
+  if (!workers.empty())
+    run_name += "_upload_contexts_" + std::to_string(workers.size());
+  if (draw_statistics)
+    draw_statistics->finish();
+  frame_timer.finish();
+  if (frame_capture) {
+    frame_capture->finish();
+    std::cout << "Captured " << frame_capture->get_frames_captured()
+              << " frames to " << capture_options.directory << " ("
+              << frame_capture->get_stalls()
+              << " waited for an earlier readback)\n";
+    frame_capture.reset();
+  }
+  frame_timer.print_summary(std::cout, run_name);
+  if (!timer_options.output_path.empty())
+    frame_timer.write_results(timer_options.output_path, run_name);
+
+  // Clean up, the worker contexts go before glfw does
+  if (reupload.valid())
+    wait_for_worker_fence(reupload.get());
+  workers.clear();
   glDeleteVertexArrays(1, &VAO);
   glDeleteBuffers(1, &VBO);
-  glDeleteBuffers(1, &UBO_0);
-  glDeleteProgram(shader_program);
+  glDeleteBuffers(1, &UBO);
+  if (back_UBO != 0)
+    glDeleteBuffers(1, &back_UBO);
+  shader_variants.clear();
 
-  glfwTerminate();
+  if (!headless.enabled)
+    glfwTerminate();
   return 0;
 }